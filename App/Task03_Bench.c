@@ -0,0 +1,117 @@
+/**
+  ******************************************************************************
+  * @file    Task03_Bench.c
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   Context switch benchmark of the preemption thresholds.
+  *
+  *          Bench_Src produces a burst of messages every tick for the higher
+  *          priority Bench_Sink.  Without thresholds, each message preempts
+  *          the producer (two switches per message).  With OS_PREEMPT_THRESH_EN
+  *          the producer's threshold keeps Bench_Sink out until the burst is
+  *          posted, and the sink then drains the queue in one go.
+  *
+  *          Call Bench_Start() before OSStart(), build once with
+  *          OS_PREEMPT_THRESH_EN 0 and once with 1, and compare Bench_SwCtr
+  *          (context switches per BENCH_PERIOD ticks) in the debugger.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "minos.h"																  /* Header file for MinOS. */
+
+#define BENCH_BURST              8      /* Messages produced per tick          */
+#define BENCH_PERIOD          1000      /* Ticks between two reports           */
+
+#define Bench_Report_PRIO        3
+#define Bench_Report_STK_SIZE  128
+#define Bench_Sink_PRIO          4
+#define Bench_Sink_STK_SIZE    128
+#define Bench_Src_PRIO           5
+#define Bench_Src_THRESH         4      /* Bench_Sink can't preempt the burst  */
+#define Bench_Src_STK_SIZE     128
+
+/* Public variables ----------------------------------------------------------*/
+INT32U   Bench_SwCtr;                   /* Context switches of the last period */
+INT32U   Bench_MsgCtr;                  /* Messages received in the last period*/
+
+OS_STK   Bench_Report_Stk[Bench_Report_STK_SIZE];
+OS_STK   Bench_Sink_Stk[Bench_Sink_STK_SIZE];
+OS_STK   Bench_Src_Stk[Bench_Src_STK_SIZE];
+
+/* Private variables ---------------------------------------------------------*/
+static OS_EVENT *Bench_Q;
+static void     *Bench_QTbl[BENCH_BURST];
+static INT32U    Bench_Rx;
+
+
+/**
+  * @brief  		Producer, a burst of BENCH_BURST messages every tick.
+  * @function  	None
+  * @RunPeriod 	1 tick
+	*/
+void Bench_Src(void)
+{
+	INT32U i;
+
+	for(;;) {
+		for (i = 0; i < BENCH_BURST; i++) {
+			OSQPost(Bench_Q, (void *)i);
+		}
+		OSTimeDly(1);
+	}
+}
+
+/**
+  * @brief  		Consumer of Bench_Src.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Bench_Sink(void)
+{
+	INT8U err;
+
+	for(;;) {
+		OSQPend(Bench_Q, 0, &err);
+		Bench_Rx++;
+	}
+}
+
+/**
+  * @brief  		Samples the switch counter every BENCH_PERIOD ticks.
+  * @function  	None
+  * @RunPeriod 	BENCH_PERIOD ticks
+	*/
+void Bench_Report(void)
+{
+	INT32U sw;
+	INT32U rx;
+
+	for(;;) {
+		sw = OSCtxSwCtr;
+		rx = Bench_Rx;
+		OSTimeDly(BENCH_PERIOD);
+		Bench_SwCtr  = OSCtxSwCtr - sw;
+		Bench_MsgCtr = Bench_Rx   - rx;
+	}
+}
+
+/**
+  * @brief  		Creates the benchmark queue and tasks, call it before OSStart().
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Bench_Start(void)
+{
+	Bench_Q = OSQCreate(Bench_QTbl, BENCH_BURST);
+
+	OSTask_Create(Bench_Report);
+	OSTask_Create(Bench_Sink);
+#if OS_PREEMPT_THRESH_EN > 0
+	OSTask_CreateExt(Bench_Src);
+#else
+	OSTask_Create(Bench_Src);
+#endif
+}
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
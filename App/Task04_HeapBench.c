@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file    Task04_HeapBench.c
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   Cycle count benchmark of OSHeapAlloc()/OSHeapFree() against the
+  *          malloc()/free() of the C library, on target.
+  *
+  *          Both allocators run the same pseudo-random sequence of allocations
+  *          (8 to 256 bytes) and frees over HEAP_BENCH_SLOTS live blocks.  The
+  *          average and worst cycle counts of each call are left in Heap_Bench
+  *          for the debugger.  Needs OS_HEAP_EN, and a C library heap (Heap_Size
+  *          in the startup file) at least as large as OS_HEAP_SIZE.
+  *
+  *          Call Heap_BenchStart() before OSStart(), Heap_BenchDone is set once
+  *          both runs are over.  Test/heap runs the same sequence on the host
+  *          against glibc.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "minos.h"																  /* Header file for MinOS. */
+#include <stdlib.h>
+
+#if OS_HEAP_EN > 0
+
+#define HEAP_BENCH_SLOTS        32      /* Blocks alive at the same time       */
+#define HEAP_BENCH_OPS       10000      /* Calls measured per allocator        */
+
+#define Heap_BenchTask_PRIO      2
+#define Heap_BenchTask_STK_SIZE 128
+
+typedef struct {
+	INT32U  AllocAvg;                     /* CPU cycles                          */
+	INT32U  AllocMax;
+	INT32U  FreeAvg;
+	INT32U  FreeMax;
+	INT32U  Failed;                       /* Allocations which returned NULL     */
+} HEAP_BENCH_DATA;
+
+/* Public variables ----------------------------------------------------------*/
+HEAP_BENCH_DATA  Heap_Bench[2];         /* [0] OSHeapAlloc(), [1] malloc()     */
+INT8U            Heap_BenchDone;
+
+OS_STK           Heap_BenchTask_Stk[Heap_BenchTask_STK_SIZE];
+
+/* Private variables ---------------------------------------------------------*/
+static void     *Heap_BenchPtr[HEAP_BENCH_SLOTS];
+
+
+/**
+  * @brief  		Runs the sequence with one allocator.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+static void Heap_BenchRun(HEAP_BENCH_DATA *pdata, INT8U libc)
+{
+	INT32U seed = 1;
+	INT32U i, slot, size, t0, dt;
+	INT32U nalloc = 0, nfree = 0, salloc = 0, sfree = 0;
+
+	pdata->AllocMax = 0;
+	pdata->FreeMax  = 0;
+	pdata->Failed   = 0;
+	for (i = 0; i < HEAP_BENCH_OPS; i++) {
+		seed = seed * 1664525u + 1013904223u;                 /* Same sequence for both */
+		slot = (seed >> 8) % HEAP_BENCH_SLOTS;
+		size = 8 + ((seed >> 16) & 0xF8);
+		if (Heap_BenchPtr[slot] != (void *)0) {
+			t0 = DWT->CYCCNT;
+			if (libc) { free(Heap_BenchPtr[slot]); } else { OSHeapFree(Heap_BenchPtr[slot]); }
+			dt = DWT->CYCCNT - t0;
+			Heap_BenchPtr[slot] = (void *)0;
+			sfree += dt; nfree++;
+			if (dt > pdata->FreeMax) pdata->FreeMax = dt;
+		} else {
+			t0 = DWT->CYCCNT;
+			Heap_BenchPtr[slot] = libc ? malloc(size) : OSHeapAlloc(size);
+			dt = DWT->CYCCNT - t0;
+			if (Heap_BenchPtr[slot] == (void *)0) pdata->Failed++;
+			salloc += dt; nalloc++;
+			if (dt > pdata->AllocMax) pdata->AllocMax = dt;
+		}
+	}
+	for (slot = 0; slot < HEAP_BENCH_SLOTS; slot++) {
+		if (libc) { free(Heap_BenchPtr[slot]); } else { OSHeapFree(Heap_BenchPtr[slot]); }
+		Heap_BenchPtr[slot] = (void *)0;
+	}
+	pdata->AllocAvg = nalloc ? salloc / nalloc : 0;
+	pdata->FreeAvg  = nfree  ? sfree  / nfree  : 0;
+}
+
+/**
+  * @brief  		Benchmark task, runs once then sleeps.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Heap_BenchTask(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;         /* Start the cycle counter */
+	DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+	Heap_BenchRun(&Heap_Bench[0], 0);
+	Heap_BenchRun(&Heap_Bench[1], 1);
+	Heap_BenchDone = 1;
+
+	for(;;) {
+		OSTimeDly(1000);
+	}
+}
+
+/**
+  * @brief  		Creates the benchmark task, call it before OSStart().
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Heap_BenchStart(void)
+{
+	OSTask_Create(Heap_BenchTask);
+}
+
+#endif
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
@@ -16,6 +16,8 @@
 
 #define  OS_GLOBALS  																															/* OS_EXT is BLANK.  */
 #include <minos.h>
+#include <string.h>
+#include <stddef.h>
 
 
 /*
@@ -31,13 +33,50 @@ typedef struct os_tcb {
 #if OS_Q_EN > 0
     OS_EVENT        *OSTCBEventPtr;         /* Pointer to          event control block                 */
     void            *OSTCBMsg;              /* Message received from OSMboxPost() or OSQPost()         */
-    
+#endif
+
+#if OS_EVENT_EN > 0
     INT8U            OSTCBStat;             /* Task      status                                        */
     INT8U            OSTCBStatPend;         /* Task PEND status                                        */    
 #endif
 
     INT16U           OSTCBDly;              /* Nbr ticks to delay task or, timeout waiting for event   */
     INT8U            OSTCBPrio;             /* Task priority (0 == highest)                            */
+
+#if OS_PREEMPT_THRESH_EN > 0
+    INT8U            OSTCBThresh;           /* Preemption threshold (OSTCBThresh <= OSTCBPrio)         */
+#endif
+
+#if (OS_STAT_EN > 0) && (OS_Q_EN > 0)
+    INT32U           OSTCBPendStart;        /* OSTime when the task started to wait on a queue         */
+#endif
+
+#if OS_HEAP_EN > 0
+    INT32U           OSTCBHeapUsed;         /* Heap bytes currently charged to the task                */
+    INT32U           OSTCBHeapPeak;         /* Highest value reached by OSTCBHeapUsed                  */
+#endif
+
+#if OS_HRT_EN > 0
+    struct os_tcb   *OSTCBHRTNext;          /* Next     TCB in the list of high resolution timeouts    */
+    struct os_tcb   *OSTCBHRTPrev;          /* Previous TCB in the list of high resolution timeouts    */
+    INT32U           OSTCBHRTDeadline;      /* OS_HRT_Now() value at which the timeout expires         */
+#endif
+
+#if OS_TASK_BASIC_EN > 0
+    void           (*OSTCBTask)(void);      /* Code of a basic task                                    */
+#endif
+
+#if OS_Q_TRACE_EN > 0
+    OS_Q_TS          OSTCBMsgTs;            /* Timestamps of OSTCBMsg                                  */
+    INT32U           OSTCBTraceSrc;         /* Start of the flow of the last traced message received   */
+#endif
+
+#if OS_LAT_EN > 0
+    INT32U           OSTCBRdyTs;            /* OS_TS_GET() when the task was made ready                */
+    INT32U           OSTCBLatCtr;           /* Number of wake-ups measured                             */
+    INT32U           OSTCBLatMax;           /* Longest wake-to-run latency                             */
+    INT32U           OSTCBLatHist[OS_LAT_BUCKETS];  /* Log2 histogram of wake-to-run latencies     */
+#endif
 } OS_TCB;
 
 OS_EXT  INT32U     OSRdyTbl;                        /* Table of tasks which are ready to run    */
@@ -47,6 +86,100 @@ OS_EXT  OS_TCB    *OSTCBHighRdy;                    /* Pointer to highest priori
 OS_EXT  OS_TCB    *OSTCBList;                       /* Pointer to doubly linked list of TCBs    */
 OS_EXT  OS_TCB     OSTCBTbl[OS_TASK_IDLE_PRIO + 1]; /* Table of TCBs                            */
 
+#if OS_HEAP_EN > 0
+/*
+*********************************************************************************************************
+*                                          HEAP BLOCK HEADER
+*
+*  Free blocks are kept in OS_HEAP_FL_CNT x OS_HEAP_SL_CNT segregated lists.  The first level splits
+*  sizes by powers of two, the second level splits each power of two in OS_HEAP_SL_CNT equal ranges;
+*  one bitmap per level finds a non-empty list with a single count-trailing-zeros.
+*********************************************************************************************************
+*/
+
+typedef struct os_heap_blk {
+    struct os_heap_blk  *OSHeapBlkPrevPhys;     /* Physically previous block                       */
+    INT32U               OSHeapBlkSize;         /* Payload size in bytes, bit 0 set if block free  */
+    INT8U                OSHeapBlkOwner;        /* Priority of the task charged for the block      */
+    INT8U                OSHeapBlkPad[7];       /* Header size multiple of 8 (payload alignment)   */
+    struct os_heap_blk  *OSHeapBlkNextFree;     /* Free blocks only (overlaps the payload)         */
+    struct os_heap_blk  *OSHeapBlkPrevFree;
+} OS_HEAP_BLK;
+
+#define  OS_HEAP_SL_LOG2              3u
+#define  OS_HEAP_SL_CNT              (1u << OS_HEAP_SL_LOG2)
+#define  OS_HEAP_FL_SHIFT            (OS_HEAP_SL_LOG2 + 2u)     /* Blocks below 32 bytes in FL 0   */
+#define  OS_HEAP_SMALL_BLK           (1u << OS_HEAP_FL_SHIFT)
+#define  OS_HEAP_FL_CNT              20u                        /* Blocks up to 16 MB              */
+#define  OS_HEAP_HDR                 ((INT32U)offsetof(OS_HEAP_BLK, OSHeapBlkNextFree))
+#define  OS_HEAP_MIN_BLK             (sizeof(OS_HEAP_BLK) - OS_HEAP_HDR)
+#define  OS_HEAP_BLK_FREE            0x01u
+#define  OS_HEAP_OWNER_NONE          0xFFu                      /* Allocated before OSStart()      */
+
+#define  OS_HEAP_SIZE_GET(pblk)      ((pblk)->OSHeapBlkSize & ~(INT32U)7u)
+#define  OS_HEAP_NEXT_PHYS(pblk)     ((OS_HEAP_BLK *)((INT8U *)(pblk) + OS_HEAP_HDR + OS_HEAP_SIZE_GET(pblk)))
+
+OS_EXT  INT64U        OSHeapMem[OS_HEAP_SIZE / 8];              /* Heap storage (8 bytes aligned)  */
+OS_EXT  INT32U        OSHeapFLBitmap;                           /* Non-empty first level ranges    */
+OS_EXT  INT8U         OSHeapSLBitmap[OS_HEAP_FL_CNT];           /* Non-empty second level lists    */
+OS_EXT  OS_HEAP_BLK  *OSHeapFreeTbl[OS_HEAP_FL_CNT][OS_HEAP_SL_CNT];
+OS_EXT  INT32U        OSHeapUsed;                               /* Bytes allocated (with headers)  */
+OS_EXT  INT32U        OSHeapUsedPeak;
+
+static  void          OS_HeapInit (void);
+#endif
+
+#if OS_WORK_EN > 0
+OS_EXT  OS_STK     OSTaskWorkStk[OS_TASK_WORK_STK_SIZE];      /* Worker task stack              */
+OS_EXT  void      *OSWorkQTbl[OS_WORK_Q_SIZE];      /* Storage of the kernel work queue         */
+#endif
+
+#if OS_PREEMPT_THRESH_EN > 0
+OS_EXT  INT32U     OSTaskStartedTbl;                /* Tasks dispatched and not blocked since   */
+#endif
+
+#if OS_HRT_EN > 0
+OS_EXT  OS_TCB    *OSHRTList;                       /* TCBs sorted by high resolution deadline  */
+#endif
+
+#if OS_LAT_EN > 0
+OS_EXT  INT32U     OSLatRdyTbl;                     /* Tasks made ready, not switched in yet    */
+#endif
+
+#if OS_Q_TRACE_EN > 0
+OS_EXT  INT32U     OSQTraceSrcTbl;                  /* Tasks whose OSTCBTraceSrc is valid       */
+#endif
+
+#if OS_TASK_BASIC_EN > 0
+OS_EXT  OS_STK     OSTaskBasicStk[OS_TASK_BASIC_STK_SIZE];    /* Stack shared by basic tasks    */
+OS_EXT  INT32U     OSTaskBasicTbl;                  /* Tasks which are basic tasks              */
+OS_EXT  INT32U     OSTaskBasicRunTbl;               /* Basic tasks with a frame on the stack    */
+OS_EXT  INT32U     OSTaskBasicActTbl;               /* Basic tasks activated while running      */
+#endif
+
+static  OS_STK    *OS_TaskStkInit (void (*task)(void), OS_STK *ptos);
+static  void       OS_TCBInit     (OS_TCB *ptcb, OS_STK *stk, INT8U prio);
+#if OS_TASK_BASIC_EN > 0
+static  void       OS_TaskBasicRun (void);
+static  OS_STK    *OS_TaskBasicTos (void);
+#endif
+#if OS_Q_EN > 0
+static  void       OS_QInit       (OS_EVENT *pevent, void **start, INT16U size);
+static  void      *OS_QPendAny    (OS_EVENT **pevents, INT8U nevents, INT16U timeout, INT32U us,
+                                   INT8U *pwhich, INT8U *perr);
+#endif
+#if OS_IPC_EN > 0
+static  void      *OS_IPCPend     (OS_EVENT *pevent, INT16U timeout, INT32U us, INT8U *perr);
+#endif
+#if OS_STREAM_EN > 0
+static  INT16U     OS_StreamRead  (OS_STREAM *pstream, void *pdata, INT16U len, INT16U timeout, INT32U us,
+                                   INT8U *perr);
+#endif
+#if OS_Q_TRACE_EN > 0
+static  void       OS_QTraceStamp (OS_Q_TS *pts);
+static  void       OS_QTraceRecv  (OS_EVENT *pevent, OS_Q_TS *pts);
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -57,9 +190,38 @@ OS_EXT  OS_TCB     OSTCBTbl[OS_TASK_IDLE_PRIO + 1]; /* Table of TCBs
 */
 
 #define  Trigger_PendSV()             (SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk)
-#define  OS_ENTER_CRITICAL()          {cpu_sr = __get_PRIMASK();__disable_irq();}//不管当前中断使能如何，我要关中断了
-#define  OS_EXIT_CRITICAL()           {__set_PRIMASK(cpu_sr);}                   //将中断状态恢复到我关之前
-#define  CPU_CntTrailZeros(data)       __CLZ(__RBIT(data))
+
+#if (OS_LAT_EN > 0) || (OS_Q_TRACE_EN > 0)
+#define  OS_TS_GET()                  (DWT->CYCCNT)                              /* CPU cycle counter */
+#endif
+
+#if OS_LAT_EN > 0
+#define  OS_TASK_RDY_MARK(ptcb)       {if ((OSLatRdyTbl & (1u << (ptcb)->OSTCBPrio)) == 0) {        \
+                                           OSLatRdyTbl       |= (1u << (ptcb)->OSTCBPrio);         \
+                                           (ptcb)->OSTCBRdyTs = OS_TS_GET();}}   /* Keep the first */
+#else
+#define  OS_TASK_RDY_MARK(ptcb)
+#endif
+
+#if OS_TASK_BASIC_EN > 0
+#define  OS_TASK_IS_BASIC()           ((OSTaskBasicTbl & (1u << OSTCBCur->OSTCBPrio)) != 0)
+#else
+#define  OS_TASK_IS_BASIC()           0
+#endif
+
+#if OS_SCHED_LOCK_EN > 0
+#define  OS_SCHED_IS_LOCKED()         (OSLockNesting > 0)
+#else
+#define  OS_SCHED_IS_LOCKED()         0
+#endif
+
+#if (OS_TASK_BASIC_EN > 0) || (OS_SCHED_LOCK_EN > 0)
+#define  OS_TASK_BLOCK_CHK()          {if (OS_TASK_IS_BASIC() || OS_SCHED_IS_LOCKED()) {            \
+                                           OS_EXIT_CRITICAL();                                    \
+                                           while(1);}}          /* Basic tasks and locked code MUST NOT block */
+#else
+#define  OS_TASK_BLOCK_CHK()
+#endif
 
 
 /*
@@ -68,7 +230,8 @@ OS_EXT  OS_TCB     OSTCBTbl[OS_TASK_IDLE_PRIO + 1]; /* Table of TCBs
 *
 * Description: This function is called by other MinOS services to determine whether a new, high
 *              priority task has been made ready to run.  This function is invoked by TASK level code
-*              and is also used to reschedule tasks from ISRs (see OSIntExit()).
+*              and is also used to reschedule tasks from ISRs (see OSIntExit()).  While the scheduler is
+*              locked, the request is only recorded and OSSchedUnlock() performs a single switch.
 *
 * Arguments  : none
 *
@@ -79,22 +242,130 @@ OS_EXT  OS_TCB     OSTCBTbl[OS_TASK_IDLE_PRIO + 1]; /* Table of TCBs
 
 void OS_Sched (void)
 {
+    INT8U      prio;
+#if OS_PREEMPT_THRESH_EN > 0
+    INT8U      started;
+#endif
     OS_CPU_SR  cpu_sr = 0;
     
     OS_ENTER_CRITICAL();
 		
+#if OS_SCHED_LOCK_EN > 0
+    if ((OSIntNesting == 0) &&                          /* Scheduler locked, defer to OSSchedUnlock()   */
+        (OSLockNesting >  0)) {
+        OSSchedPend = 1u;
+    }
+    if ((OSIntNesting == 0) &&                          /* Schedule only if all ISRs done and ...       */
+        (OSLockNesting == 0)) {                         /* ... scheduler is not locked                  */
+#else
     if (OSIntNesting == 0) {                            /* Schedule only if all ISRs done and ...       */
+#endif
         /** OS_TCBGetHighest **/
-        OSTCBHighRdy  = &OSTCBTbl[ (INT8U) CPU_CntTrailZeros( OSRdyTbl  )];
+        prio = (INT8U) CPU_CntTrailZeros( OSRdyTbl );
+#if OS_PREEMPT_THRESH_EN > 0
+        OSTaskStartedTbl &= OSRdyTbl;                   /* A task that blocked has completed its run    */
+        if (OSTCBCur != (OS_TCB *)0) {
+            OSTaskStartedTbl |= OSRdyTbl & ( 1 << OSTCBCur->OSTCBPrio );
+        }
+        if (OSTaskStartedTbl != 0) {                    /* Highest started task has the lowest threshold*/
+            started = (INT8U) CPU_CntTrailZeros( OSTaskStartedTbl );
+            if (prio >= OSTCBTbl[started].OSTCBThresh) {/* Not above its threshold, resume it instead   */
+                prio = started;
+            }
+        }
+#endif
+        OSTCBHighRdy  = &OSTCBTbl[prio];
         if (OSTCBHighRdy != OSTCBCur) {         	 	 /* No Ctx Sw if current task is highest rdy     */
             Trigger_PendSV();                            /* Perform a context switch, see os_cpu_a.asm   */
         }        
+#if OS_LAT_EN > 0
+        else {
+            OSLatRdyTbl &= ~( 1u << prio );              /* Readied itself, it is already running        */
+        }
+#endif
     }
 		
     OS_EXIT_CRITICAL();
 }
 
 
+#if OS_SCHED_LOCK_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          PREVENT SCHEDULING
+*
+* Description: This function is used to prevent rescheduling to take place.  This allows your application
+*              to prevent context switches until you are ready to permit context switching.  Interrupts
+*              remain enabled: ISRs can still post, but the switch they request is deferred.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+* Notes      : 1) You MUST invoke OSSchedLock() and OSSchedUnlock() in pair.  In other words, for every
+*                 call to OSSchedLock() you MUST have a call to OSSchedUnlock().
+*              2) The current task MUST NOT block (delay or pend) while the scheduler is locked.
+*********************************************************************************************************
+*/
+
+void  OSSchedLock (void)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (OSIntNesting == 0) {                     /* Can't call from an ISR                             */
+        OS_ENTER_CRITICAL();
+        if (OSLockNesting < 255u) {              /* Prevent OSLockNesting from wrapping back to 0      */
+            OSLockNesting++;                     /* Increment lock nesting level                       */
+        }
+        if ((SCB->ICSR & SCB_ICSR_PENDSVSET_Msk) != 0) {
+            SCB->ICSR   = SCB_ICSR_PENDSVCLR_Msk;/* Switch not taken yet, defer it as well            */
+            OSSchedPend = 1u;
+        }
+        OS_EXIT_CRITICAL();
+    }
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          ENABLE SCHEDULING
+*
+* Description: This function is used to re-allow rescheduling.  When the last lock is released, the
+*              reschedules requested meanwhile (by tasks, or by ISRs through OSIntExit()) are collapsed
+*              into a single context switch.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+* Notes      : 1) You MUST invoke OSSchedLock() and OSSchedUnlock() in pair.  In other words, for every
+*                 call to OSSchedLock() you MUST have a call to OSSchedUnlock().
+*********************************************************************************************************
+*/
+
+void  OSSchedUnlock (void)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (OSIntNesting == 0) {                     /* Can't call from an ISR                             */
+        OS_ENTER_CRITICAL();
+        if (OSLockNesting > 0) {                 /* Do not decrement if already 0                      */
+            OSLockNesting--;                     /* Decrement lock nesting level                       */
+            if ((OSLockNesting == 0) &&          /* See if scheduler is enabled and ...                */
+                (OSSchedPend   != 0)) {          /* ... a reschedule was deferred                      */
+                OSSchedPend = 0;
+                OS_EXIT_CRITICAL();
+                OS_Sched();                      /* See if a HPT is ready                              */
+                return;
+            }
+        }
+        OS_EXIT_CRITICAL();
+    }
+}
+#endif
+
+/*$PAGE*/
 /*
 *********************************************************************************************************
 *                                         PROCESS SYSTEM TICK
@@ -116,6 +387,15 @@ void OS_SysTick_Handler (void)
     
     OSIntEnter();       /** Tell MinOS that we are starting an ISR                **/
 
+#if OS_STAT_EN > 0
+    OSTime++;                                          /* Update the 32-bit tick counter               */
+#endif
+
+    OSTimeTickHook();                                  /* Call user definable hook                     */
+#if OS_AO_EN > 0
+    OS_AOTick();                                       /* Count down the time events of the AOs        */
+#endif
+
     ptcb = OSTCBList;                                  /* Point at first TCB in TCB list               */
     while (ptcb->OSTCBPrio != OS_TASK_IDLE_PRIO) {     /* Go through all TCBs in TCB list              */
 
@@ -123,9 +403,9 @@ void OS_SysTick_Handler (void)
             
             if (--ptcb->OSTCBDly == 0) {               /* Decrement nbr of ticks to end of delay       */
                                                        /* Check for timeout                            */
-#if OS_Q_EN > 0                
-                if((ptcb->OSTCBStat & OS_STAT_PEND_Q) != OS_STAT_RDY) {
-                    ptcb->OSTCBStat  &= ~(INT8U)OS_STAT_PEND_Q;//清空“等待Q中”标志，若该任务只是在等待Q，则该
+#if OS_EVENT_EN > 0                
+                if((ptcb->OSTCBStat & OS_STAT_PEND_ANY) != OS_STAT_RDY) {
+                    ptcb->OSTCBStat  &= ~(INT8U)OS_STAT_PEND_ANY;//清空“等待Q中”标志，若该任务只是在等待Q，则该
                                                                //语句相当于将任务设为“就绪”          	 /* Yes, Clear status flag   */
                     ptcb->OSTCBStatPend = OS_STAT_PEND_TO;     //等待状态：已超时 （已就绪，凭此标志判定是如何就绪的）               /* Indicate PEND timeout    */
                 } 
@@ -139,6 +419,7 @@ void OS_SysTick_Handler (void)
 #endif        
                 {  /* Is task suspended?       */
                     OSRdyTbl |= ( 1 << ptcb->OSTCBPrio );                  /* No,  Make ready          */
+                    OS_TASK_RDY_MARK(ptcb);
                 }
             }
         }
@@ -150,6 +431,203 @@ void OS_SysTick_Handler (void)
     OSIntExit();        /** Tell MinOS that we are leaving the ISR and reschedule **/
 }
 
+#if OS_HRT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     HIGH RESOLUTION TIMER (TIM2)
+*
+* Description: Default implementation of the high resolution timer port on TIM2, a 32-bit timer clocked
+*              at SystemCoreClock / 2 (APB1 timer clock of the STM32F4).  These functions are weak: define
+*              them elsewhere to use another timer or to run the kernel on a simulated clock.
+*********************************************************************************************************
+*/
+
+void __attribute__((weak)) OS_HRT_Init (void)
+{
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+    TIM2->CR1     = 0;
+    TIM2->PSC     = (SystemCoreClock / 2u) / (1000000u * OS_HRT_TICKS_PER_US) - 1u;
+    TIM2->ARR     = 0xFFFFFFFFu;                       /* Free-running over the 32 bits                */
+    TIM2->EGR     = TIM_EGR_UG;                        /* Load the prescaler                           */
+    TIM2->DIER    = 0;
+    TIM2->SR      = 0;
+    TIM2->CR1     = TIM_CR1_CEN;
+    NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+INT32U __attribute__((weak)) OS_HRT_Now (void)
+{
+    return (TIM2->CNT);
+}
+
+void __attribute__((weak)) OS_HRT_Arm (INT32U deadline)
+{
+    TIM2->CCR1  =  deadline;
+    TIM2->SR    = ~TIM_SR_CC1IF;                       /* Forget an older match                        */
+    TIM2->DIER |=  TIM_DIER_CC1IE;
+}
+
+void __attribute__((weak)) OS_HRT_Disarm (void)
+{
+    TIM2->DIER &= ~TIM_DIER_CC1IE;
+    TIM2->SR    = ~TIM_SR_CC1IF;
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                  SERVICE HIGH RESOLUTION TIMEOUTS
+*
+* Description: This function readies the tasks whose deadline has passed and arms the timer for the
+*              earliest remaining one.  If that deadline passes while the timer is being armed, the
+*              compare match may be missed, so the deadline is checked again after arming.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+* Note(s)    : 1) This function is INTERNAL to MinOS and MUST be called with interrupts disabled.
+*              2) A task readied by a post stays in the list until it runs again (see OS_HRTRemove()).
+*                 If its deadline expires meanwhile, the task is only made ready (again).
+*********************************************************************************************************
+*/
+
+static void  OS_HRTService (void)
+{
+    OS_TCB  *ptcb;
+
+    while (OSHRTList != (OS_TCB *)0) {
+        ptcb = OSHRTList;
+        if ((INT32S)(OS_HRT_Now() - ptcb->OSTCBHRTDeadline) < 0) {
+            OS_HRT_Arm(ptcb->OSTCBHRTDeadline);        /* Deadline in the future, arm the timer        */
+            if ((INT32S)(OS_HRT_Now() - ptcb->OSTCBHRTDeadline) < 0) {
+                return;                                /* ... still in the future, the timer will fire */
+            }
+        }
+        OSHRTList = ptcb->OSTCBHRTNext;                /* Deadline reached, unlink the TCB             */
+        if (OSHRTList != (OS_TCB *)0) {
+            OSHRTList->OSTCBHRTPrev = (OS_TCB *)0;
+        }
+        ptcb->OSTCBHRTNext = (OS_TCB *)0;
+#if OS_EVENT_EN > 0
+        if ((ptcb->OSTCBStat & OS_STAT_PEND_ANY) != OS_STAT_RDY) {
+            ptcb->OSTCBStat    &= ~(INT8U)OS_STAT_PEND_ANY;
+            ptcb->OSTCBStatPend = OS_STAT_PEND_TO;     /* Indicate PEND timeout                        */
+        }
+        if (ptcb->OSTCBStat == OS_STAT_RDY)
+#endif
+        {
+            OSRdyTbl |= ( 1 << ptcb->OSTCBPrio );      /* Make ready                                   */
+            OS_TASK_RDY_MARK(ptcb);
+        }
+    }
+    OS_HRT_Disarm();                                   /* No more deadlines                            */
+}
+
+/*
+*********************************************************************************************************
+*                              INSERT/REMOVE A TASK IN THE HIGH RESOLUTION LIST
+*
+* Description: OS_HRTInsert() links 'ptcb' in OSHRTList in deadline order, after the TCBs with the same
+*              deadline.  OS_HRTRemove() unlinks it if it is still in the list.  The timer is re-armed when
+*              the head of the list changes.  Both MUST be called with interrupts disabled.
+*********************************************************************************************************
+*/
+
+static void  OS_HRTInsert (OS_TCB *ptcb, INT32U deadline)
+{
+    OS_TCB  *pprev;
+    OS_TCB  *pnext;
+
+    ptcb->OSTCBHRTDeadline = deadline;
+    pprev = (OS_TCB *)0;
+    pnext = OSHRTList;
+    while ((pnext != (OS_TCB *)0) && ((INT32S)(pnext->OSTCBHRTDeadline - deadline) <= 0)) {
+        pprev = pnext;
+        pnext = pnext->OSTCBHRTNext;
+    }
+    ptcb->OSTCBHRTPrev = pprev;
+    ptcb->OSTCBHRTNext = pnext;
+    if (pnext != (OS_TCB *)0) {
+        pnext->OSTCBHRTPrev = ptcb;
+    }
+    if (pprev != (OS_TCB *)0) {
+        pprev->OSTCBHRTNext = ptcb;
+    } else {
+        OSHRTList = ptcb;                              /* New earliest deadline                        */
+        OS_HRTService();
+    }
+}
+
+static void  OS_HRTRemove (OS_TCB *ptcb)
+{
+    if (ptcb->OSTCBHRTPrev != (OS_TCB *)0) {
+        ptcb->OSTCBHRTPrev->OSTCBHRTNext = ptcb->OSTCBHRTNext;
+        if (ptcb->OSTCBHRTNext != (OS_TCB *)0) {
+            ptcb->OSTCBHRTNext->OSTCBHRTPrev = ptcb->OSTCBHRTPrev;
+        }
+        ptcb->OSTCBHRTPrev = (OS_TCB *)0;
+        ptcb->OSTCBHRTNext = (OS_TCB *)0;
+    } else if (OSHRTList == ptcb) {                    /* Head of the list                             */
+        OSHRTList = ptcb->OSTCBHRTNext;
+        if (OSHRTList != (OS_TCB *)0) {
+            OSHRTList->OSTCBHRTPrev = (OS_TCB *)0;
+        }
+        ptcb->OSTCBHRTNext = (OS_TCB *)0;
+        OS_HRTService();                               /* Arm for the next deadline                    */
+    }
+}
+
+/*
+*********************************************************************************************************
+*                                   CONVERT A TIMEOUT INTO A DEADLINE
+*
+* Description: This function returns the timer value 'us' microseconds from now.  'us' is clamped to
+*              OS_HRT_US_MAX so that the deadline stays within half the range of the timer and is ordered
+*              correctly in OSHRTList.  This function is INTERNAL to MinOS.
+*********************************************************************************************************
+*/
+
+static INT32U  OS_HRTDeadline (INT32U us)
+{
+    if (us > OS_HRT_US_MAX) {
+        us = OS_HRT_US_MAX;
+    }
+    return (OS_HRT_Now() + us * OS_HRT_TICKS_PER_US);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                   PROCESS HIGH RESOLUTION TIMER MATCH
+*
+* Description: This function is the compare interrupt handler of the high resolution timer.  A host
+*              simulation calls it when its simulated clock reaches the deadline passed to OS_HRT_Arm().
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void OS_HRT_Handler (void)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    OS_ENTER_CRITICAL();
+
+    OSIntEnter();
+
+    OS_HRT_Disarm();                                   /* Acknowledge the compare match                */
+    OS_HRTService();                                   /* Ready expired tasks, arm for the next one    */
+
+    OS_EXIT_CRITICAL();
+
+    OSIntExit();
+}
+#endif
+
 /*
 ;********************************************************************************************************
 ;                                         HANDLE PendSV EXCEPTION
@@ -184,10 +662,15 @@ void OS_SysTick_Handler (void)
 ;              therefore safe to assume that context being switched out was using the process stack (PSP).
 ;********************************************************************************************************
 */
+#ifndef OS_HOST_SIM
 __asm void OS_PendSV_Handler (void)
 {
     extern  OSTCBCur
     extern  OSTCBHighRdy
+    extern  OSCtxSwCtr
+#if (OS_LAT_EN > 0) || (OS_TASK_BASIC_EN > 0)
+    extern  OS_TaskSwHook
+#endif
     
     PRESERVE8
     
@@ -202,8 +685,18 @@ __asm void OS_PendSV_Handler (void)
     LDR     R1, [R1]            /*                                                         */
     STR     R0, [R1]            /* R0 is SP of process being switched out                  */
                                 /*                                                         */
+    LDR     R1, =OSCtxSwCtr     /* OSCtxSwCtr++;  only switches which really take place    */
+    LDR     R2, [R1]            /*                                                         */
+    ADDS    R2, R2, #1          /*                                                         */
+    STR     R2, [R1]            /*                                                         */
+                                /*                                                         */
                                 /* At this point, entire context of process has been saved */
 _nosave                         /*                                                         */
+#if (OS_LAT_EN > 0) || (OS_TASK_BASIC_EN > 0)
+    PUSH    {R0, LR}            /* OS_TaskSwHook();  (R0 keeps the stack 8-byte aligned)   */
+    BL      OS_TaskSwHook       /*                                                         */
+    POP     {R0, LR}            /*                                                         */
+#endif
 	LDR     R0, =OSTCBCur       /* OSTCBCur  = OSTCBHighRdy;                               */
     LDR     R1, =OSTCBHighRdy   /*                                                         */
     LDR     R2, [R1]            /*                                                         */
@@ -222,59 +715,240 @@ _nosave                         /*
                                 
 	ALIGN
 }
+#endif
 
-
+#if (OS_LAT_EN > 0) || (OS_TASK_BASIC_EN > 0)
+/*$PAGE*/
 /*
 *********************************************************************************************************
-*                                DELAY TASK 'n' TICKS   (n from 0 to 65535)
+*                                           TASK SWITCH HOOK
 *
-* Description: This function is called to delay execution of the currently running task until the
-*              specified number of system ticks expires.  This, of course, directly equates to delaying
-*              the current task for some time to expire.  No delay will result If the specified delay is
-*              0.  If the specified delay is greater than 0 then, a context switch will result.
+* Description: This function is called by OS_PendSV_Handler() with interrupts disabled, once the context of
+*              the task switched out has been saved and before OSTCBHighRdy is switched in.
+*              - A basic task switched in for a new activation gets a fresh frame on the shared stack,
+*                just below the frame of the last basic task it preempted.
+*              - If the task switched in was made ready since it last ran, the time elapsed since then
+*                is added to its latency histogram.
 *
-* Arguments  : ticks     is the time delay that the task will be suspended in number of clock 'ticks'.
-*                        Note that by specifying 0, the task will not be delayed.
+* Arguments  : none
 *
 * Returns    : none
+*
+* Note(s)    : This function is INTERNAL to MinOS.
 *********************************************************************************************************
 */
-void  OSTimeDly (INT16U ticks)
+
+void  OS_TaskSwHook (void)
 {
-    OS_CPU_SR  cpu_sr = 0;
+    OS_TCB  *ptcb;
+#if OS_TASK_BASIC_EN > 0
+    OS_STK  *ptos;
+#endif
+#if OS_LAT_EN > 0
+    INT32U   lat;
+    INT8U    i;
+#endif
 
-    if (OSIntNesting > 0)                       /* See if trying to call from an ISR                  */
-    {
-        return;
+    ptcb = OSTCBHighRdy;
+#if OS_TASK_BASIC_EN > 0
+    if (((OSTaskBasicTbl    & ( 1u << ptcb->OSTCBPrio )) != 0) &&
+        ((OSTaskBasicRunTbl & ( 1u << ptcb->OSTCBPrio )) == 0)) {
+        ptos               = OS_TaskBasicTos() - 1;     /* Task starts with an 8-byte aligned SP    */
+        ptcb->OSTCBStkPtr  = OS_TaskStkInit(OS_TaskBasicRun, ptos);
+        OSTaskBasicRunTbl |= ( 1u << ptcb->OSTCBPrio );
     }
-    
-    if (ticks > 0)                              /* 0 means no delay!                                  */
-    {
-        OS_ENTER_CRITICAL();
-
-        OSRdyTbl &= ~( 1<< OSTCBCur->OSTCBPrio );/* Delay current task                                 */ 
-        OSTCBCur->OSTCBDly = ticks;              /* Load ticks in TCB                                  */
-        OS_EXIT_CRITICAL();
-        OS_Sched();                              /* Find next task to run!                             */
+#endif
+#if OS_LAT_EN > 0
+    if ((OSLatRdyTbl & ( 1u << ptcb->OSTCBPrio )) != 0) {
+        OSLatRdyTbl &= ~( 1u << ptcb->OSTCBPrio );
+        lat          = OS_TS_GET() - ptcb->OSTCBRdyTs;
+        i            = (INT8U)(31u - CPU_CntLeadZeros(lat | 1u));   /* floor(log2(lat))              */
+        if (i >= OS_LAT_BUCKETS) {
+            i = OS_LAT_BUCKETS - 1u;
+        }
+        ptcb->OSTCBLatHist[i]++;
+        ptcb->OSTCBLatCtr++;
+        if (lat > ptcb->OSTCBLatMax) {
+            ptcb->OSTCBLatMax = lat;
+        }
     }
+#endif
 }
+#endif
+
+#if OS_LAT_EN > 0
 
 /*$PAGE*/
 /*
 *********************************************************************************************************
-*                                              IDLE TASK
+*                                      GET A TASK'S LATENCY HISTOGRAM
 *
-* Description: This task is internal to MinOS and executes whenever no other higher priority tasks
-*              executes because they are ALL waiting for event(s) to occur.
+* Description: This function returns the wake-to-run latency histogram of a task: for every wake-up
+*              (post, timeout or delay expiry), the CPU cycles elapsed from the moment the task was made
+*              ready to the moment OS_PendSV_Handler() switched it in.
 *
-* Arguments  : none
+* Arguments  : prio     is the priority of the task.
+*
+*              pdata    is a pointer to where the histogram will be copied.
+*
+*              reset    is 1 to clear the histogram of the task once it has been copied.
 *
 * Returns    : none
 *
+* Note(s)    : The 99th percentile is only known to the bucket: OSLatP99 is the upper bound of the bucket
+*              it falls in.
 *********************************************************************************************************
 */
 
-void __attribute__((weak)) OS_TaskIdle (void) 
+void  OSTaskLatGet (INT8U prio, OS_LAT_DATA *pdata, INT8U reset)
+{
+    OS_TCB    *ptcb;
+    INT32U     sum;
+    INT8U      i;
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (prio > OS_TASK_IDLE_PRIO) {
+        while(1);                                       /* Error: Minos Panic OS_ERR_PRIO_INVALID   */
+    }
+    ptcb = &OSTCBTbl[prio];
+
+    OS_ENTER_CRITICAL();
+    pdata->OSLatCtr = ptcb->OSTCBLatCtr;
+    pdata->OSLatMax = ptcb->OSTCBLatMax;
+    for (i = 0; i < OS_LAT_BUCKETS; i++) {
+        pdata->OSLatHist[i] = ptcb->OSTCBLatHist[i];
+    }
+    if (reset == 1) {
+        ptcb->OSTCBLatCtr = 0;
+        ptcb->OSTCBLatMax = 0;
+        for (i = 0; i < OS_LAT_BUCKETS; i++) {
+            ptcb->OSTCBLatHist[i] = 0;
+        }
+    }
+    OS_EXIT_CRITICAL();
+
+    pdata->OSLatP99 = 0;                                /* Walk down until 1% of the samples are seen */
+    sum             = 0;
+    i               = OS_LAT_BUCKETS;
+    while ((i > 0) && (pdata->OSLatCtr > 0)) {
+        i--;
+        sum += pdata->OSLatHist[i];
+        if (sum >= ((pdata->OSLatCtr + 99u) / 100u)) {
+            pdata->OSLatP99 = (i == (OS_LAT_BUCKETS - 1u)) ? pdata->OSLatMax : ((2u << i) - 1u);
+            break;
+        }
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                DELAY TASK 'n' TICKS   (n from 0 to 65535)
+*
+* Description: This function is called to delay execution of the currently running task until the
+*              specified number of system ticks expires.  This, of course, directly equates to delaying
+*              the current task for some time to expire.  No delay will result If the specified delay is
+*              0.  If the specified delay is greater than 0 then, a context switch will result.
+*
+* Arguments  : ticks     is the time delay that the task will be suspended in number of clock 'ticks'.
+*                        Note that by specifying 0, the task will not be delayed.
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void  OSTimeDly (INT16U ticks)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (OSIntNesting > 0)                       /* See if trying to call from an ISR                  */
+    {
+        return;
+    }
+    
+    if (ticks > 0)                              /* 0 means no delay!                                  */
+    {
+        OS_ENTER_CRITICAL();
+
+        OS_TASK_BLOCK_CHK();
+        OSRdyTbl &= ~( 1<< OSTCBCur->OSTCBPrio );/* Delay current task                                 */ 
+        OSTCBCur->OSTCBDly = ticks;              /* Load ticks in TCB                                  */
+        OS_EXIT_CRITICAL();
+        OS_Sched();                              /* Find next task to run!                             */
+    }
+}
+
+#if OS_HRT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                DELAY TASK 'n' MICROSECONDS
+*
+* Description: This function is identical to OSTimeDly() but the delay is given in microseconds and is
+*              timed by the high resolution timer instead of the tick.
+*
+* Arguments  : us        is the time delay in microseconds.  0 means no delay.  Delays longer than
+*                        OS_HRT_US_MAX are clamped to OS_HRT_US_MAX.
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void  OSTimeDlyUs (INT32U us)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (OSIntNesting > 0)                       /* See if trying to call from an ISR                  */
+    {
+        return;
+    }
+
+    if (us > 0)
+    {
+        OS_ENTER_CRITICAL();
+        OS_TASK_BLOCK_CHK();
+        OSRdyTbl &= ~( 1<< OSTCBCur->OSTCBPrio );/* Delay current task                                 */
+        OS_HRTInsert(OSTCBCur, OS_HRTDeadline(us));
+        OS_EXIT_CRITICAL();
+        OS_Sched();                              /* Find next task to run!                             */
+    }
+}
+#endif
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                              TICK HOOK
+*
+* Description: This function is called every tick by OS_SysTick_Handler(), with interrupts disabled.  It
+*              can be redefined by the application to run periodic ISR level code.  It MUST be short.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+*********************************************************************************************************
+*/
+
+void __attribute__((weak)) OSTimeTickHook (void)
+{
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                              IDLE TASK
+*
+* Description: This task is internal to MinOS and executes whenever no other higher priority tasks
+*              executes because they are ALL waiting for event(s) to occur.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+*********************************************************************************************************
+*/
+
+void __attribute__((weak)) OS_TaskIdle (void) 
 {
     
     for (;;) 
@@ -283,6 +957,87 @@ void __attribute__((weak)) OS_TaskIdle (void)
     }
 }
 
+#if OS_WORK_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                              WORKER TASK
+*
+* Description: This task is internal to MinOS and runs the jobs posted to OSWorkQ.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+*********************************************************************************************************
+*/
+
+static void OS_TaskWork (void)
+{
+    OSWorkRun(OSWorkQ);
+}
+#endif
+
+#if OS_STATIC_CFG_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          STATIC CONFIGURATION
+*
+*  Stacks and queue storage of the objects listed in OS_STATIC_TASK_TBL and OS_STATIC_Q_TBL, and the
+*  const descriptor tables (kept in flash) from which OSInit() builds them.  A priority out of range, a
+*  stack smaller than OS_STATIC_STK_MIN, an empty queue or too many queues fail to compile (negative
+*  array size); two tasks sharing a priority fail to compile in OSInit() (duplicate case value).
+*********************************************************************************************************
+*/
+
+typedef struct os_task_cfg {
+    void      (*OSTaskCfgFnct)(void);       /* Task code                                               */
+    OS_STK     *OSTaskCfgStk;               /* Top of the task's stack                                 */
+    INT8U       OSTaskCfgPrio;              /* Task priority                                           */
+} OS_TASK_CFG;
+
+#define  OS_TASK_CHK(name, prio, stk)       typedef char OS_TASK_CHK_PRIO_##name[((prio) < OS_TASK_IDLE_PRIO)  ? 1 : -1]; \
+                                            typedef char OS_TASK_CHK_STK_##name[((stk) >= OS_STATIC_STK_MIN) ? 1 : -1];
+#define  OS_TASK_STK_DEF(name, prio, stk)   OS_STK name##_Stk[stk];
+#define  OS_TASK_CFG_DEF(name, prio, stk)   {name, &name##_Stk[(stk) - 1], prio},
+#define  OS_TASK_CASE(name, prio, stk)      case prio:
+
+OS_STATIC_TASK_TBL(OS_TASK_CHK)
+OS_STATIC_TASK_TBL(OS_TASK_STK_DEF)
+
+static const OS_TASK_CFG OSTaskCfgTbl[] = {         /* Idle task first, it ends up last in OSTCBList    */
+    {OS_TaskIdle, &OSTaskIdleStk[OS_TASK_IDLE_STK_SIZE - 1], OS_TASK_IDLE_PRIO},
+#if OS_WORK_EN > 0
+    {OS_TaskWork, &OSTaskWorkStk[OS_TASK_WORK_STK_SIZE - 1], OS_TASK_WORK_PRIO},
+#endif
+    OS_STATIC_TASK_TBL(OS_TASK_CFG_DEF)
+};
+
+#if OS_Q_EN > 0
+typedef struct os_q_cfg {
+    void      **OSQCfgStart;                /* Storage of the queue                                    */
+    INT16U      OSQCfgSize;                 /* Number of entries in the storage                        */
+} OS_Q_CFG;
+
+#define  OS_Q_CHK(name, size)               typedef char OS_Q_CHK_SIZE_##name[((size) > 0) ? 1 : -1];
+#define  OS_Q_STO_DEF(name, size)           static void *name##_QTbl[size];
+#define  OS_Q_CFG_DEF(name, size)           {name##_QTbl, size},
+
+OS_STATIC_Q_TBL(OS_Q_CHK)
+OS_STATIC_Q_TBL(OS_Q_STO_DEF)
+typedef char OS_Q_CHK_CNT[(OS_Q_STATIC_CNT <= OS_MAX_QS) ? 1 : -1];
+
+static const OS_Q_CFG OSQCfgTbl[OS_Q_STATIC_CNT + 1] = {
+#if OS_WORK_EN > 0
+    {OSWorkQTbl, OS_WORK_Q_SIZE},
+#endif
+    OS_STATIC_Q_TBL(OS_Q_CFG_DEF)
+    {(void **)0, 0}                                 /* End of table, not a queue                       */
+};
+#endif
+#endif
+
 /*$PAGE*/
 /*
 *********************************************************************************************************
@@ -300,6 +1055,9 @@ void __attribute__((weak)) OS_TaskIdle (void)
 void  OSInit (void)
 {
     INT8U    i;
+#if OS_STATIC_CFG_EN > 0
+    const OS_TASK_CFG  *pcfg;
+#endif
 		
 #if OS_Q_EN > 0
     OS_EVENT  *pevent1,*pevent2;    
@@ -308,16 +1066,71 @@ void  OSInit (void)
     pevent2 = &OSEventTbl[1];
     for (i = 0; i < (OS_MAX_QS - 1); i++) 
     {
+#if OS_EVENT_TYPE_EN > 0
+        pevent1->OSEventType = OS_EVENT_TYPE_UNUSED;
+#endif
         pevent1->OSEventPtr = pevent2;
         pevent1++;
         pevent2++;
     }
+#if OS_EVENT_TYPE_EN > 0
+    pevent1->OSEventType = OS_EVENT_TYPE_UNUSED;
+#endif
     pevent1->OSEventPtr = (OS_EVENT *)0;
     OSEventFreeList     = &OSEventTbl[0];
+
+#if OS_STATIC_CFG_EN > 0
+    for (i = 0; i < OS_Q_STATIC_CNT; i++)       /* Build the static queues in the first ECBs ...   */
+    {
+        OS_QInit(&OSEventTbl[i], OSQCfgTbl[i].OSQCfgStart, OSQCfgTbl[i].OSQCfgSize);
+    }
+    OSEventFreeList     = (OS_Q_STATIC_CNT < OS_MAX_QS) ? &OSEventTbl[OS_Q_STATIC_CNT]
+                                                        : (OS_EVENT *)0;  /* ... the others are free    */
+#endif
 #endif	
+
+#if OS_STREAM_EN > 0
+    for (i = 0; i < (OS_MAX_STREAMS - 1); i++)  /* Initialize the free list of OS_STREAMs   */
+    {
+        OSStreamTbl[i].OSStreamNext = &OSStreamTbl[i + 1];
+    }
+    OSStreamTbl[OS_MAX_STREAMS - 1].OSStreamNext = (OS_STREAM *)0;
+    OSStreamFreeList    = &OSStreamTbl[0];
+#endif
 		
     OSIntNesting  = 0;
+    OSCtxSwCtr    = 0;            /* Clear the context switch counter         */
+#if OS_STAT_EN > 0
+    OSTime        = 0;            /* Clear the 32-bit system clock            */
+#endif
+#if OS_SCHED_LOCK_EN > 0
+    OSLockNesting = 0;
+    OSSchedPend   = 0;
+#endif
     OSRdyTbl      = 0;            /* Clear the ready list                     */
+#if OS_TASK_BASIC_EN > 0
+    OSTaskBasicTbl    = 0;
+    OSTaskBasicRunTbl = 0;
+    OSTaskBasicActTbl = 0;
+#endif
+#if OS_LAT_EN > 0
+    OSLatRdyTbl   = 0;
+#endif
+#if OS_Q_TRACE_EN > 0
+    OSQTraceSrcTbl = 0;
+#endif
+#if (OS_LAT_EN > 0) || (OS_Q_TRACE_EN > 0)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;  /* Start the cycle counter (OS_TS_GET())   */
+    DWT->CYCCNT       = 0;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+#if OS_PREEMPT_THRESH_EN > 0
+    OSTaskStartedTbl = 0;
+#endif
+#if OS_HRT_EN > 0
+    OSHRTList     = (OS_TCB *)0;  /* No high resolution timeout pending       */
+    OS_HRT_Init();
+#endif
 		
     OSTCBHighRdy  = (OS_TCB *)&OSTCBTbl[OS_TASK_IDLE_PRIO];
     OSTCBCur      = (OS_TCB *)0;		
@@ -329,9 +1142,182 @@ void  OSInit (void)
     
     OSTCBList        = (OS_TCB *)0;//The First task MUST BE Idle_Task and BE the last of list                      /* TCB lists initializations          */
 
+#if OS_STATIC_CFG_EN > 0
+    switch (0)                                             /* Fails to compile if two tasks share a    */
+    {                                                      /* ... priority (duplicate case value)      */
+        OS_STATIC_TASK_TBL(OS_TASK_CASE)
+#if OS_WORK_EN > 0
+        case OS_TASK_WORK_PRIO:
+#endif
+        case OS_TASK_IDLE_PRIO:
+        default:
+             break;
+    }
+
+    for (i = 0; i < (sizeof(OSTaskCfgTbl) / sizeof(OSTaskCfgTbl[0])); i++)
+    {                                                      /* Build the TCBs and the ready list        */
+        pcfg = &OSTaskCfgTbl[i];
+        OS_TCBInit(&OSTCBTbl[pcfg->OSTaskCfgPrio],
+                    OS_TaskStkInit(pcfg->OSTaskCfgFnct, pcfg->OSTaskCfgStk),
+                    pcfg->OSTaskCfgPrio);
+    }
+    OSTCBHighRdy     = &OSTCBTbl[CPU_CntTrailZeros(OSRdyTbl)];
+#else
     OSTaskCreate(OS_TaskIdle,
                 &OSTaskIdleStk[OS_TASK_IDLE_STK_SIZE - 1],
                  OS_TASK_IDLE_PRIO);                       /* Create the Idle Task                     */
+#endif
+
+#if OS_HEAP_EN > 0
+    OS_HeapInit();                                         /* Whole heap is one free block             */
+#endif
+
+#if OS_WORK_EN > 0
+#if OS_STATIC_CFG_EN > 0
+    OSWorkQ = OS_Q(OSWorkQ);                               /* Work queue and task are static           */
+#else
+    OSWorkQ = OSQCreate(OSWorkQTbl, OS_WORK_Q_SIZE);       /* Create the kernel work queue             */
+    OSTaskCreate(OS_TaskWork,
+                &OSTaskWorkStk[OS_TASK_WORK_STK_SIZE - 1],
+                 OS_TASK_WORK_PRIO);                       /* Create the Worker Task                   */
+#endif
+#endif
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        INITIALIZE A TASK'S STACK
+*
+* Description: This function builds the stack frame of a task as if it had been preempted at the first
+*              instruction of 'task'.  This function is INTERNAL to MinOS.
+*
+* Arguments  : task     is a pointer to the task's code
+*
+*              ptos     is a pointer to the task's top of stack.
+*
+* Returns    : The new top of stack, to be saved in the task's TCB.
+*********************************************************************************************************
+*/
+
+static OS_STK  *OS_TaskStkInit (void (*task)(void), OS_STK *ptos)
+{
+    OS_STK    *stk;
+
+    stk       = ptos;                    /* Load stack pointer                                 */
+                                         /* Registers stacked as if [Auto-Saved on exception]  */
+    *(  stk)  = (OS_STK)0x01000000L;     /* xPSR                                               */
+    *(--stk)  = (OS_STK)task;            /* Entry Point                                        */
+    *(--stk)  = (OS_STK)0xFFFFFFFEL;     /* R14 (LR) (init value will cause fault if ever used)  0xFFFFFFFE:返回ARM状态、线程模式、使用PSP,见EXC_RETURN */                                       
+    *(--stk)  = (OS_STK)0x12121212L;     /* R12                                                */
+    *(--stk)  = (OS_STK)0x03030303L;     /* R3                                                 */
+    *(--stk)  = (OS_STK)0x02020202L;     /* R2                                                 */
+    *(--stk)  = (OS_STK)0x01010101L;     /* R1                                                 */
+    *(--stk)  = (OS_STK)0x00000000L;     /* R0                                                 */
+    
+                                         /* Remaining registers saved on process stack[PSP]    */
+    *(--stk)  = (OS_STK)0x11111111L;     /* R11                                                */
+    *(--stk)  = (OS_STK)0x10101010L;     /* R10                                                */
+    *(--stk)  = (OS_STK)0x09090909L;     /* R9                                                 */
+    *(--stk)  = (OS_STK)0x08080808L;     /* R8                                                 */
+    *(--stk)  = (OS_STK)0x07070707L;     /* R7                                                 */
+    *(--stk)  = (OS_STK)0x06060606L;     /* R6                                                 */
+    *(--stk)  = (OS_STK)0x05050505L;     /* R5                                                 */
+    *(--stk)  = (OS_STK)0x04040404L;     /* R4                                                 */
+
+
+
+
+
+//    *(--stk)  = (OS_STK)0x02000000u;     /* FPSCR                                                  */
+//                                         /* Initialize S0-S31 floating point registers             */
+//    *(--stk)  = (OS_STK)0x41F80000u;     /* S31                                                    */
+//    *(--stk)  = (OS_STK)0x41F00000u;     /* S30                                                    */
+//    *(--stk)  = (OS_STK)0x41E80000u;     /* S29                                                    */
+//    *(--stk)  = (OS_STK)0x41E00000u;     /* S28                                                    */
+//    *(--stk)  = (OS_STK)0x41D80000u;     /* S27                                                    */
+//    *(--stk)  = (OS_STK)0x41D00000u;     /* S26                                                    */
+//    *(--stk)  = (OS_STK)0x41C80000u;     /* S25                                                    */
+//    *(--stk)  = (OS_STK)0x41C00000u;     /* S24                                                    */
+//    *(--stk)  = (OS_STK)0x41B80000u;     /* S23                                                    */
+//    *(--stk)  = (OS_STK)0x41B00000u;     /* S22                                                    */
+//    *(--stk)  = (OS_STK)0x41A80000u;     /* S21                                                    */
+//    *(--stk)  = (OS_STK)0x41A00000u;     /* S20                                                    */
+//    *(--stk)  = (OS_STK)0x41980000u;     /* S19                                                    */
+//    *(--stk)  = (OS_STK)0x41900000u;     /* S18                                                    */
+//    *(--stk)  = (OS_STK)0x41880000u;     /* S17                                                    */
+//    *(--stk)  = (OS_STK)0x41800000u;     /* S16                                                    */
+//    *(--stk)  = (OS_STK)0x41700000u;     /* S15                                                    */
+//    *(--stk)  = (OS_STK)0x41600000u;     /* S14                                                    */
+//    *(--stk)  = (OS_STK)0x41500000u;     /* S13                                                    */
+//    *(--stk)  = (OS_STK)0x41400000u;     /* S12                                                    */
+//    *(--stk)  = (OS_STK)0x41300000u;     /* S11                                                    */
+//    *(--stk)  = (OS_STK)0x41200000u;     /* S10                                                    */
+//    *(--stk)  = (OS_STK)0x41100000u;     /* S9                                                     */
+//    *(--stk)  = (OS_STK)0x41000000u;     /* S8                                                     */
+//    *(--stk)  = (OS_STK)0x40E00000u;     /* S7                                                     */
+//    *(--stk)  = (OS_STK)0x40C00000u;     /* S6                                                     */
+//    *(--stk)  = (OS_STK)0x40A00000u;     /* S5                                                     */
+//    *(--stk)  = (OS_STK)0x40800000u;     /* S4                                                     */
+//    *(--stk)  = (OS_STK)0x40400000u;     /* S3                                                     */
+//    *(--stk)  = (OS_STK)0x40000000u;     /* S2                                                     */
+//    *(--stk)  = (OS_STK)0x3F800000u;     /* S1                                                     */
+//    *(--stk)  = (OS_STK)0x00000000u;     /* S0                                                     */
+
+    return (stk);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                           INITIALIZE A TCB
+*
+* Description: This function initializes the TCB of a task, links it in OSTCBList and makes the task
+*              ready to run.  This function is INTERNAL to MinOS.
+*
+* Arguments  : ptcb     is a pointer to the TCB of the task (&OSTCBTbl[prio])
+*
+*              stk      is the top of stack returned by OS_TaskStkInit()
+*
+*              prio     is the task's priority.
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_TCBInit (OS_TCB *ptcb, OS_STK *stk, INT8U prio)
+{
+    ptcb->OSTCBStkPtr     = stk;                    /* Load Stack pointer in TCB                */
+    ptcb->OSTCBPrio       = prio;                   /* Load task priority into TCB              */
+#if ( OS_PREEMPT_THRESH_EN > 0 )
+    ptcb->OSTCBThresh     = prio;                   /* Task is fully preemptible by default     */
+#endif
+    ptcb->OSTCBDly        = 0;                      /* Task is not delayed                      */
+#if ( OS_HEAP_EN > 0 )
+    ptcb->OSTCBHeapUsed   = 0;                      /* Nothing allocated yet                    */
+    ptcb->OSTCBHeapPeak   = 0;
+#endif
+#if ( OS_HRT_EN > 0 )
+    ptcb->OSTCBHRTNext    = (OS_TCB *)0;            /* No high resolution timeout               */
+    ptcb->OSTCBHRTPrev    = (OS_TCB *)0;
+#endif
+#if ( OS_LAT_EN > 0 )
+    memset(ptcb->OSTCBLatHist, 0, sizeof(ptcb->OSTCBLatHist));
+    ptcb->OSTCBLatCtr     = 0;                      /* No latency measured yet                  */
+    ptcb->OSTCBLatMax     = 0;
+#endif
+
+#if ( OS_EVENT_EN > 0 )
+    ptcb->OSTCBStat       = OS_STAT_RDY;            /* Task is ready to run                     */
+    ptcb->OSTCBStatPend   = OS_STAT_PEND_OK;        /* Clear pend status                        */
+#endif		
+#if ( OS_Q_EN > 0 )
+    ptcb->OSTCBEventPtr   = (OS_EVENT  *)0;         /* Task is not pending on an  event         */
+#endif		
+    
+    ptcb->OSTCBNext       = OSTCBList;              /* Link into TCB chain                      */
+    OSTCBList             = ptcb;
+    OSRdyTbl             |= (1 << ptcb->OSTCBPrio );/* Make task ready to run                   */
 }
 
 /*$PAGE*/
@@ -369,93 +1355,18 @@ void  OSInit (void)
 
 void  OSTaskCreate (void (*task)(void), OS_STK *ptos, INT8U prio)
 {
-    OS_STK    *stk;
     OS_TCB    *ptcb;
     
-    stk       = ptos;                    /* Load stack pointer                                 */
     ptcb      = &OSTCBTbl[prio];
 		
     if ( ptcb->OSTCBNext == (OS_TCB *)0 )  /* Make sure task doesn't already exist at this priority  */
     {
-                                             /* Registers stacked as if [Auto-Saved on exception]  */
-        *(  stk)  = (OS_STK)0x01000000L;     /* xPSR                                               */
-        *(--stk)  = (OS_STK)task;            /* Entry Point                                        */
-        *(--stk)  = (OS_STK)0xFFFFFFFEL;     /* R14 (LR) (init value will cause fault if ever used)  0xFFFFFFFE:返回ARM状态、线程模式、使用PSP,见EXC_RETURN */                                       
-        *(--stk)  = (OS_STK)0x12121212L;     /* R12                                                */
-        *(--stk)  = (OS_STK)0x03030303L;     /* R3                                                 */
-        *(--stk)  = (OS_STK)0x02020202L;     /* R2                                                 */
-        *(--stk)  = (OS_STK)0x01010101L;     /* R1                                                 */
-        *(--stk)  = (OS_STK)0x00000000L;     /* R0                                                 */
-        
-                                             /* Remaining registers saved on process stack[PSP]    */
-        *(--stk)  = (OS_STK)0x11111111L;     /* R11                                                */
-        *(--stk)  = (OS_STK)0x10101010L;     /* R10                                                */
-        *(--stk)  = (OS_STK)0x09090909L;     /* R9                                                 */
-        *(--stk)  = (OS_STK)0x08080808L;     /* R8                                                 */
-        *(--stk)  = (OS_STK)0x07070707L;     /* R7                                                 */
-        *(--stk)  = (OS_STK)0x06060606L;     /* R6                                                 */
-        *(--stk)  = (OS_STK)0x05050505L;     /* R5                                                 */
-        *(--stk)  = (OS_STK)0x04040404L;     /* R4                                                 */
-
-
-
-
-
-    //    *(--stk)  = (OS_STK)0x02000000u;     /* FPSCR                                                  */
-    //                                         /* Initialize S0-S31 floating point registers             */
-    //    *(--stk)  = (OS_STK)0x41F80000u;     /* S31                                                    */
-    //    *(--stk)  = (OS_STK)0x41F00000u;     /* S30                                                    */
-    //    *(--stk)  = (OS_STK)0x41E80000u;     /* S29                                                    */
-    //    *(--stk)  = (OS_STK)0x41E00000u;     /* S28                                                    */
-    //    *(--stk)  = (OS_STK)0x41D80000u;     /* S27                                                    */
-    //    *(--stk)  = (OS_STK)0x41D00000u;     /* S26                                                    */
-    //    *(--stk)  = (OS_STK)0x41C80000u;     /* S25                                                    */
-    //    *(--stk)  = (OS_STK)0x41C00000u;     /* S24                                                    */
-    //    *(--stk)  = (OS_STK)0x41B80000u;     /* S23                                                    */
-    //    *(--stk)  = (OS_STK)0x41B00000u;     /* S22                                                    */
-    //    *(--stk)  = (OS_STK)0x41A80000u;     /* S21                                                    */
-    //    *(--stk)  = (OS_STK)0x41A00000u;     /* S20                                                    */
-    //    *(--stk)  = (OS_STK)0x41980000u;     /* S19                                                    */
-    //    *(--stk)  = (OS_STK)0x41900000u;     /* S18                                                    */
-    //    *(--stk)  = (OS_STK)0x41880000u;     /* S17                                                    */
-    //    *(--stk)  = (OS_STK)0x41800000u;     /* S16                                                    */
-    //    *(--stk)  = (OS_STK)0x41700000u;     /* S15                                                    */
-    //    *(--stk)  = (OS_STK)0x41600000u;     /* S14                                                    */
-    //    *(--stk)  = (OS_STK)0x41500000u;     /* S13                                                    */
-    //    *(--stk)  = (OS_STK)0x41400000u;     /* S12                                                    */
-    //    *(--stk)  = (OS_STK)0x41300000u;     /* S11                                                    */
-    //    *(--stk)  = (OS_STK)0x41200000u;     /* S10                                                    */
-    //    *(--stk)  = (OS_STK)0x41100000u;     /* S9                                                     */
-    //    *(--stk)  = (OS_STK)0x41000000u;     /* S8                                                     */
-    //    *(--stk)  = (OS_STK)0x40E00000u;     /* S7                                                     */
-    //    *(--stk)  = (OS_STK)0x40C00000u;     /* S6                                                     */
-    //    *(--stk)  = (OS_STK)0x40A00000u;     /* S5                                                     */
-    //    *(--stk)  = (OS_STK)0x40800000u;     /* S4                                                     */
-    //    *(--stk)  = (OS_STK)0x40400000u;     /* S3                                                     */
-    //    *(--stk)  = (OS_STK)0x40000000u;     /* S2                                                     */
-    //    *(--stk)  = (OS_STK)0x3F800000u;     /* S1                                                     */
-    //    *(--stk)  = (OS_STK)0x00000000u;     /* S0                                                     */
-
-		
-        
         if( prio < OSTCBHighRdy->OSTCBPrio )
         {
             OSTCBHighRdy = ptcb;
         }
 
-        ptcb->OSTCBStkPtr     = stk;                    /* Load Stack pointer in TCB                */
-        ptcb->OSTCBPrio       = prio;                   /* Load task priority into TCB              */
-        ptcb->OSTCBDly        = 0;                      /* Task is not delayed                      */
-
-    #if ( OS_Q_EN > 0 )
-        ptcb->OSTCBStat       = OS_STAT_RDY;            /* Task is ready to run                     */
-        ptcb->OSTCBStatPend   = OS_STAT_PEND_OK;        /* Clear pend status                        */
-        ptcb->OSTCBEventPtr   = (OS_EVENT  *)0;         /* Task is not pending on an  event         */
-    #endif		
-        
-        ptcb->OSTCBNext       = OSTCBList;              /* Link into TCB chain                      */
-        OSTCBList             = ptcb;
-        OSRdyTbl             |= (1 << ptcb->OSTCBPrio );/* Make task ready to run                   */
+        OS_TCBInit(ptcb, OS_TaskStkInit(task, ptos), prio);
     }
     else
     {
@@ -463,260 +1374,2649 @@ void  OSTaskCreate (void (*task)(void), OS_STK *ptos, INT8U prio)
     }
 }
 
+#if OS_PREEMPT_THRESH_EN > 0
 /*$PAGE*/
 /*
 *********************************************************************************************************
-*                                          START MULTITASKING
+*                                  CREATE A TASK WITH A PREEMPTION THRESHOLD
 *
-* Description: This function is used to start the multitasking process which lets MinOS manages the
-*              task that you have created.  Before you can call OSStart(), you MUST have called OSInit()
-*              and you MUST have created at least one task.
+* Description: This function is identical to OSTaskCreate() but also assigns a preemption threshold to
+*              the task.  Once the task has been dispatched, only tasks whose priority is higher than
+*              'thresh' can preempt it until it blocks (OSTimeDly(), OSQPend() ...).  Tasks whose
+*              priority lies between 'thresh' and 'prio' thus never preempt each other.
 *
-* Arguments  : none
+* Arguments  : task     is a pointer to the task's code
 *
-* Returns    : none
+*              ptos     is a pointer to the task's top of stack.
+*
+*              prio     is the task's priority.
+*
+*              thresh   is the task's preemption threshold.  It MUST be lower or equal to 'prio', a
+*                       value equal to 'prio' means the task is fully preemptible.
+*
+* Returns    : The function CANNOT return normally if the threshold is invalid or the priority exist
 *
 *********************************************************************************************************
 */
 
-void  OSStart (void)
+void  OSTaskCreateExt (void (*task)(void), OS_STK *ptos, INT8U prio, INT8U thresh)
 {
-    OSTCBCur = OSTCBHighRdy;
-	
-    /** OSStartHighRdy **/
-    NVIC_SetPriority( PendSV_IRQn, 0xFF );
-    __set_PSP(0);
-    
-    Trigger_PendSV();         /* Trigger the PendSV exception (causes context switch) */
+    if (thresh > prio)
+    {
+        while(1);                                       /* Error: Minos Panic OS_ERR_PRIO_INVALID   */
+    }
     
-    __enable_irq();
+    OSTaskCreate(task, ptos, prio);
+    OSTCBTbl[prio].OSTCBThresh = thresh;
 }
 
-
-
-#if OS_Q_EN > 0
+/*$PAGE*/
 /*
 *********************************************************************************************************
-*                                        CREATE A MESSAGE QUEUE
+*                                   CHANGE A TASK'S PREEMPTION THRESHOLD
 *
-* Description: This function creates a message queue if free event control blocks are available.
+* Description: This function changes the preemption threshold of a task at run-time.  Raising 'thresh'
+*              back towards 'prio' may allow a waiting task to preempt at once.
 *
-* Arguments  : start         is a pointer to the base address of the message queue storage area.  The
-*                            storage area MUST be declared as an array of pointers to 'void' as follows
+* Arguments  : prio     is the priority of the task to change.
 *
-*                            void *MessageStorage[size]
+*              thresh   is the new preemption threshold.  It MUST be lower or equal to 'prio'.
 *
-*              size          is the number of elements in the storage area
+* Returns    : The previous preemption threshold of the task.
 *
-* Returns    : != (OS_EVENT *)0  is a pointer to the event control clock (OS_EVENT) associated with the
-*                                created queue
-*              == (OS_EVENT *)0  if no event control blocks were available or an error was detected
 *********************************************************************************************************
 */
 
-OS_EVENT  *OSQCreate (void **start, INT16U size)
+INT8U  OSTaskThreshSet (INT8U prio, INT8U thresh)
 {
-    OS_EVENT  *pevent;
+    INT8U      old;
     OS_CPU_SR  cpu_sr = 0;
-
-    OS_ENTER_CRITICAL();
-    if (OSEventFreeList != (OS_EVENT *)0) {      /* See if pool of free ECB pool was empty             */
+    
+    if (thresh > prio)
+    {
+        while(1);                                       /* Error: Minos Panic OS_ERR_PRIO_INVALID   */
+    }
+    
+    OS_ENTER_CRITICAL();
+    old                        = OSTCBTbl[prio].OSTCBThresh;
+    OSTCBTbl[prio].OSTCBThresh = thresh;
+    OS_EXIT_CRITICAL();
+    
+    OS_Sched();                                         /* A waiting task may now be allowed to run */
+    return (old);
+}
+#endif
+
+#if OS_STAT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                       ITERATE OVER THE TASKS
+*
+* Description: This function takes a snapshot of the first existing task whose priority is 'prio' or
+*              lower, so that a diagnostics task can walk all tasks:
+*
+*                           for (prio = OSTaskNext(0, &data); prio != OS_PRIO_NONE;
+*                                prio = OSTaskNext(prio + 1, &data)) {
+*                               Send 'data';
+*                           }
+*
+* Arguments  : prio          is the priority to start from
+*
+*              pdata         is a pointer to where the snapshot will be deposited
+*
+* Returns    : The priority of the task found or, OS_PRIO_NONE if there is no more task.
+*
+*********************************************************************************************************
+*/
+
+INT8U  OSTaskNext (INT8U prio, OS_TASK_DATA *pdata)
+{
+    OS_TCB    *ptcb;
+    OS_CPU_SR  cpu_sr = 0;
+
+    OS_ENTER_CRITICAL();
+    for (; prio <= OS_TASK_IDLE_PRIO; prio++) {
+        ptcb = &OSTCBTbl[prio];
+        if ((ptcb->OSTCBNext != (OS_TCB *)0) ||         /* Only the Idle Task ends the TCB list     */
+            (prio == OS_TASK_IDLE_PRIO)) {
+            pdata->OSTaskPrio     = prio;
+#if OS_EVENT_EN > 0
+            pdata->OSTaskStat     = ptcb->OSTCBStat;
+#else
+            pdata->OSTaskStat     = OS_STAT_RDY;
+#endif
+            pdata->OSTaskRdy      = (INT8U)((OSRdyTbl >> prio) & 1u);
+            pdata->OSTaskDly      = ptcb->OSTCBDly;
+#if OS_Q_EN > 0
+            pdata->OSTaskEventPtr = ptcb->OSTCBEventPtr;
+#endif
+            OS_EXIT_CRITICAL();
+            return (prio);
+        }
+    }
+    OS_EXIT_CRITICAL();
+    return (OS_PRIO_NONE);
+}
+#endif
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          START MULTITASKING
+*
+* Description: This function is used to start the multitasking process which lets MinOS manages the
+*              task that you have created.  Before you can call OSStart(), you MUST have called OSInit()
+*              and you MUST have created at least one task.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+*********************************************************************************************************
+*/
+
+void  OSStart (void)
+{
+    OSTCBCur = OSTCBHighRdy;
+	
+    /** OSStartHighRdy **/
+    NVIC_SetPriority( PendSV_IRQn, 0xFF );
+    __set_PSP(0);
+    
+    Trigger_PendSV();         /* Trigger the PendSV exception (causes context switch) */
+    
+    __enable_irq();
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     GET THE CURRENT TASK'S PRIORITY
+*
+* Description: This function returns the priority of the running task.  It lets a task function shared
+*              by several tasks find its own data.
+*
+* Arguments  : none
+*
+* Returns    : The priority of the calling task.
+*********************************************************************************************************
+*/
+
+INT8U  OSTaskPrioGet (void)
+{
+    return (OSTCBCur->OSTCBPrio);
+}
+
+#if OS_TASK_BASIC_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          CREATE A BASIC TASK
+*
+* Description: This function creates a basic task.  A basic task runs to completion each time it is
+*              activated (see OSTaskActivate()) and MUST NOT block (OSTimeDly(), OSQPend() ...).  All basic
+*              tasks run on OSTaskBasicStk: since a basic task only preempts lower priority ones and never
+*              waits, their frames nest in priority order and the shared stack only needs to hold the
+*              deepest preemption chain.
+*
+* Arguments  : task     is a pointer to the task's code.  It is called once per activation and returns:
+*
+*                           void Task (void)
+*                           {
+*                               Task code;
+*                           }
+*
+*              prio     is the task's priority.  A unique priority MUST be assigned to each task.
+*
+* Returns    : The function CANNOT return normally if the task priority already exist
+*
+* Note(s)    : The task is created suspended, it runs on its first activation.
+*********************************************************************************************************
+*/
+
+void  OSTaskCreateBasic (void (*task)(void), INT8U prio)
+{
+    OS_TCB    *ptcb;
+
+    ptcb      = &OSTCBTbl[prio];
+
+    if ( ptcb->OSTCBNext == (OS_TCB *)0 )  /* Make sure task doesn't already exist at this priority  */
+    {
+        ptcb->OSTCBTask = task;
+        OS_TCBInit(ptcb, (OS_STK *)0, prio);            /* Frame built on activation (OS_TaskSwHook)*/
+        OSRdyTbl       &= ~( 1u << prio );              /* Not activated yet                        */
+        OSTaskBasicTbl |=  ( 1u << prio );
+    }
+    else
+    {
+        while(1);                                       /* Error: Minos Panic OS_ERR_PRIO_EXIST     */
+    }
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                         ACTIVATE A BASIC TASK
+*
+* Description: This function makes a basic task ready to run.  If the task is already activated, one more
+*              run is recorded and the task runs again once the current run completes.  This function can
+*              be called from a task or an ISR.
+*
+* Arguments  : prio     is the priority of the basic task.
+*
+* Returns    : none
+*
+* Note(s)    : When a task activates a basic task that preempts it right away (interrupts enabled, scheduler
+*              not locked, higher priority and above the preemption thresholds), the basic task is called
+*              directly: it runs on the shared stack nested below the caller, without going through PendSV,
+*              and this function returns once it has completed.  Activations from an ISR or deferred ones
+*              are dispatched by PendSV.
+*********************************************************************************************************
+*/
+
+void  OSTaskActivate (INT8U prio)
+{
+    OS_TCB    *pcur;
+    OS_STK    *ptos;
+    INT32U     bit;
+#if OS_PREEMPT_THRESH_EN > 0
+    INT8U      started;
+#endif
+    OS_CPU_SR  cpu_sr = 0;
+
+    bit = 1u << prio;
+    OS_ENTER_CRITICAL();
+    if ((OSTaskBasicTbl & bit) == 0) {
+        OS_EXIT_CRITICAL();
+        while(1);                                       /* Error: Minos Panic not a basic task      */
+    }
+    if ((OSRdyTbl & bit) != 0) {                        /* Already activated                        */
+        OSTaskBasicActTbl |= bit;
+        OS_EXIT_CRITICAL();
+        return;
+    }
+    OSRdyTbl |= bit;
+    pcur      = OSTCBCur;
+    if ((cpu_sr != 0) || (OSIntNesting > 0) || OS_SCHED_IS_LOCKED() ||  /* Not a direct preemption  */
+        (pcur == (OS_TCB *)0) || (prio >= pcur->OSTCBPrio) ||
+        (prio != CPU_CntTrailZeros(OSRdyTbl))) {
+        OS_TASK_RDY_MARK(&OSTCBTbl[prio]);
+        OS_EXIT_CRITICAL();
+        OS_Sched();                                     /* Dispatched by PendSV                     */
+        return;
+    }
+#if OS_PREEMPT_THRESH_EN > 0
+    started = (INT8U) CPU_CntTrailZeros( (OSTaskStartedTbl & OSRdyTbl) | ( 1u << pcur->OSTCBPrio ) );
+    if (prio >= OSTCBTbl[started].OSTCBThresh) {        /* Held off by a threshold                  */
+        OS_TASK_RDY_MARK(&OSTCBTbl[prio]);
+        OS_EXIT_CRITICAL();
+        OS_Sched();
+        return;
+    }
+    OSTaskStartedTbl  |= ( 1u << pcur->OSTCBPrio );    /* The caller is preempted, not completed   */
+#endif
+    ptos               = OS_TaskBasicTos();             /* Before marking: nest below the others    */
+    OSTaskBasicRunTbl |= bit;
+    OSTCBCur           = &OSTCBTbl[prio];               /* A PendSV now saves the basic task, so    */
+    OSTCBHighRdy       = OSTCBCur;                      /* ... stay masked until on the shared stack*/
+    if ((OSTaskBasicTbl & ( 1u << pcur->OSTCBPrio )) != 0) {
+        OS_TaskBasicDirect();                           /* Caller already on the shared stack       */
+    } else {
+        OS_TaskBasicCall(ptos);                         /* Switch to the shared stack and back      */
+    }
+    OSTaskBasicRunTbl &= ~bit;                          /* Interrupts still disabled: the frame is  */
+    OSTCBCur           = pcur;                          /* ... dropped and the caller resumed       */
+    OSTCBHighRdy       = pcur;
+    OS_EXIT_CRITICAL();
+    OS_Sched();                                         /* A task readied meanwhile may outrank it  */
+}
+
+/*
+*********************************************************************************************************
+*                                          RUN A BASIC TASK
+*
+* Description: This function is the entry point of the frame built for each activation of a basic task.
+*              It calls the task's code and terminates the task when it returns: its frame is dropped and
+*              the stack below the preempted basic task is free again.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+* Note(s)    : This function is INTERNAL to MinOS.
+*********************************************************************************************************
+*/
+
+static void  OS_TaskBasicRun (void)
+{
+    OS_TCB    *ptcb;
+    INT32U     bit;
+    OS_CPU_SR  cpu_sr = 0;
+
+    ptcb = OSTCBCur;
+    bit  = 1u << ptcb->OSTCBPrio;
+    for (;;) {
+        (*ptcb->OSTCBTask)();                           /* Run to completion                        */
+
+        OS_ENTER_CRITICAL();
+        if ((OSTaskBasicActTbl & bit) != 0) {           /* Activated again meanwhile, run again     */
+            OSTaskBasicActTbl &= ~bit;
+        } else {
+            OSRdyTbl          &= ~bit;                  /* Terminate                                */
+            OSTaskBasicRunTbl &= ~bit;
+            OS_EXIT_CRITICAL();
+            OS_Sched();                                 /* Only returns if activated again before   */
+            OS_ENTER_CRITICAL();                        /* ... another task was switched in         */
+            OSTaskBasicRunTbl |=  bit;
+        }
+        OS_EXIT_CRITICAL();
+    }
+}
+
+/*
+*********************************************************************************************************
+*                                     RUN A BASIC TASK BY A DIRECT CALL
+*
+* Description: This function runs the basic task OSTCBCur to completion, for OSTaskActivate().  Unlike
+*              OS_TaskBasicRun() it returns once the task is terminated.
+*
+* Arguments  : none
+*
+* Returns    : none
+*
+* Note(s)    : 1) This function is INTERNAL to MinOS.
+*              2) It is called with interrupts disabled, on the shared stack, and enables them: OSTCBCur
+*                 already points to the basic task, so a PendSV taken before the SP is on the shared stack
+*                 would save the caller's SP as the basic task's and nest the next frames in it.
+*              3) It returns with interrupts disabled: the frame stays reserved and OSTCBCur points to the
+*                 terminated task until OSTaskActivate() has switched back to the caller.
+*********************************************************************************************************
+*/
+
+void  OS_TaskBasicDirect (void)
+{
+    OS_TCB    *ptcb;
+    INT32U     bit;
+    OS_CPU_SR  cpu_sr = 0;
+
+    ptcb = OSTCBCur;
+    bit  = 1u << ptcb->OSTCBPrio;
+    __enable_irq();                                     /* OSTaskActivate() was called unmasked     */
+    for (;;) {
+        (*ptcb->OSTCBTask)();                           /* Run to completion                        */
+
+        OS_ENTER_CRITICAL();
+        if ((OSTaskBasicActTbl & bit) == 0) {           /* Terminate                                */
+            OSRdyTbl &= ~bit;
+            return;
+        }
+        OSTaskBasicActTbl &= ~bit;                      /* Activated again meanwhile, run again     */
+        OS_EXIT_CRITICAL();
+    }
+}
+
+/*
+*********************************************************************************************************
+*                                  CALL A BASIC TASK ON THE SHARED STACK
+*
+* Description: This function switches the SP (PSP in thread mode) to ptos, calls OS_TaskBasicDirect() and
+*              restores the caller's SP.  It is called and returns with interrupts disabled: they are only
+*              enabled by OS_TaskBasicDirect(), once on the shared stack, so any exception taken meanwhile
+*              stacks there, as it would for a basic task dispatched by PendSV.
+*
+* Arguments  : ptos     is the 8-byte aligned top of the basic task's frame on OSTaskBasicStk.
+*
+* Returns    : none, with interrupts disabled (see OS_TaskBasicDirect())
+*
+* Note(s)    : This function is INTERNAL to MinOS.
+*********************************************************************************************************
+*/
+
+#ifndef OS_HOST_SIM
+__asm void OS_TaskBasicCall (OS_STK *ptos)
+{
+    extern  OS_TaskBasicDirect
+
+    PRESERVE8
+
+    PUSH    {R4, LR}            /* R4 keeps the caller's SP                                */
+    MOV     R4, SP              /*                                                         */
+    MOV     SP, R0              /* SP = ptos;                                              */
+    BL      OS_TaskBasicDirect  /* OS_TaskBasicDirect();                                   */
+    MOV     SP, R4              /* Back on the caller's stack                              */
+    POP     {R4, PC}            /*                                                         */
+
+    ALIGN
+}
+#endif
+
+/*
+*********************************************************************************************************
+*                                    TOP OF THE NEXT BASIC TASK FRAME
+*
+* Description: This function returns where the frame of a basic task being started begins: just below the
+*              last started basic task, or at the top of OSTaskBasicStk.  Called with interrupts disabled.
+*
+* Arguments  : none
+*
+* Returns    : The 8-byte aligned top of the frame.  The function CANNOT return if OSTaskBasicStk is full.
+*
+* Note(s)    : This function is INTERNAL to MinOS.
+*********************************************************************************************************
+*/
+
+static OS_STK  *OS_TaskBasicTos (void)
+{
+    OS_STK  *ptos;
+
+    if (OSTaskBasicRunTbl != 0) {                       /* Nest below the last started basic task   */
+        ptos = OSTCBTbl[CPU_CntTrailZeros(OSTaskBasicRunTbl)].OSTCBStkPtr;
+    } else {
+        ptos = &OSTaskBasicStk[OS_TASK_BASIC_STK_SIZE];
+    }
+    ptos = (OS_STK *)((INT32U)ptos & ~7u);
+    if ((ptos - 17) < &OSTaskBasicStk[0]) {
+        while(1);                                       /* Error: Minos Panic shared stack overflow */
+    }
+    return (ptos);
+}
+#endif
+
+
+
+#if OS_Q_EN > 0
+/*
+*********************************************************************************************************
+*                                        CREATE A MESSAGE QUEUE
+*
+* Description: This function creates a message queue if free event control blocks are available.
+*
+* Arguments  : start         is a pointer to the base address of the message queue storage area.  The
+*                            storage area MUST be declared as an array of pointers to 'void' as follows
+*
+*                            void *MessageStorage[size]
+*
+*              size          is the number of elements in the storage area
+*
+* Returns    : != (OS_EVENT *)0  is a pointer to the event control clock (OS_EVENT) associated with the
+*                                created queue
+*              == (OS_EVENT *)0  if no event control blocks were available or an error was detected
+*
+* Note(s)    : OSQPrioCreate() and OSIPCCreate() pass a NULL 'start' to get an ECB without a ring.
+*********************************************************************************************************
+*/
+
+OS_EVENT  *OSQCreate (void **start, INT16U size)
+{
+    OS_EVENT  *pevent;
+    OS_CPU_SR  cpu_sr = 0;
+
+    OS_ENTER_CRITICAL();
+    if (OSEventFreeList != (OS_EVENT *)0) {      /* See if pool of free ECB pool was empty             */
         pevent = OSEventFreeList;                /* Get next free event control block                  */
         OSEventFreeList = (OS_EVENT *)OSEventFreeList->OSEventPtr;
     }
     else
     {
-        while(1);//No enough free ECB
+        while(1);//No enough free ECB
+    }
+    
+    OS_QInit(pevent, start, size);
+
+    OS_EXIT_CRITICAL();
+
+    return (pevent);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        INITIALIZE A QUEUE'S ECB
+*
+* Description: This function initializes an ECB as an empty message queue.  This function is INTERNAL
+*              to MinOS, used by OSQCreate() and OSInit().
+*
+* Arguments  : pevent        is a pointer to the event control block to initialize
+*
+*              start         is a pointer to the base address of the message queue storage area, or a NULL
+*                            pointer if the ECB does not use the ring pointers (priority queues, channels)
+*
+*              size          is the number of elements in the storage area
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_QInit (OS_EVENT *pevent, void **start, INT16U size)
+{
+    pevent->OSQStart           = start;               /*      Initialize the queue                 */
+    if (start != (void **)0) {
+        pevent->OSQEnd         = &start[size];
+    } else {
+        pevent->OSQEnd         = (void **)0;          /* No storage area, no ring to point into    */
+    }
+    pevent->OSQIn              = start;
+    pevent->OSQOut             = start;
+    pevent->OSQSize            = size;
+    pevent->OSNMsgs            = 0;
+
+#if OS_EVENT_TYPE_EN > 0
+    pevent->OSEventType        = OS_EVENT_TYPE_Q;
+#endif
+    pevent->OSEventWaitTbl     = 0; /* No task waiting on event                           */
+
+#if OS_STAT_EN > 0
+    pevent->OSNMsgsPeak        = 0;
+    pevent->OSEventPostCtr     = 0;
+    pevent->OSEventPendCtr     = 0;
+    pevent->OSEventTOCtr       = 0;
+    pevent->OSEventHandoffCtr  = 0;
+    pevent->OSEventBlockMax    = 0;
+#endif
+#if OS_Q_TRACE_EN > 0
+    pevent->OSQTraceOn         = 0;                   /* Not traced until OSQTraceStart()          */
+    pevent->OSQTraceTs         = (OS_Q_TS *)0;
+#endif
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     EXTRACT A MESSAGE FROM A QUEUE
+*
+* Description: This function removes the oldest message from a queue which is not empty.  It MUST be
+*              called with interrupts disabled.  This function is INTERNAL to MinOS.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+*
+* Returns    : The message extracted.
+*********************************************************************************************************
+*/
+
+static void  *OS_QGet (OS_EVENT *pevent)
+{
+    void       *pmsg;
+#if OS_Q_PRIO_EN > 0
+    OS_Q_PRIO  *pqprio;
+    OS_Q_MSG   *pentry;
+    INT8U       level;
+#if OS_Q_TRACE_EN > 0
+    OS_Q_TS     ts;
+#endif
+
+    if (pevent->OSEventType == OS_EVENT_TYPE_Q_PRIO) {
+        pqprio = (OS_Q_PRIO *)pevent->OSEventPtr;
+        level  = (INT8U) CPU_CntTrailZeros( pqprio->OSQPrioRdyTbl );  /* Most urgent level in use   */
+        pentry = pqprio->OSQPrioHead[level];
+        pqprio->OSQPrioHead[level] = pentry->OSQMsgNext;
+        if (pentry->OSQMsgNext == (OS_Q_MSG *)0) {                    /* Level is now empty         */
+            pqprio->OSQPrioTail[level] = (OS_Q_MSG *)0;
+            pqprio->OSQPrioRdyTbl     &= ~( 1u << level );
+        }
+        pmsg                    = pentry->OSQMsgPtr;
+#if OS_Q_TRACE_EN > 0
+        ts                      = pentry->OSQMsgTs;
+#endif
+        pentry->OSQMsgNext      = pqprio->OSQPrioFreeList;            /* Return entry to free list  */
+        pqprio->OSQPrioFreeList = pentry;
+        pevent->OSNMsgs--;
+#if OS_Q_TRACE_EN > 0
+        OS_QTraceRecv(pevent, &ts);
+#endif
+        return (pmsg);
+    }
+#endif
+
+#if OS_Q_TRACE_EN > 0
+    if (pevent->OSQTraceOn != 0) {               /* Timestamps are stored at the same index            */
+        OS_QTraceRecv(pevent, &pevent->OSQTraceTs[pevent->OSQOut - pevent->OSQStart]);
+    } else {
+        OS_QTraceRecv(pevent, (OS_Q_TS *)0);
+    }
+#endif
+    //取出队列中地址数值，并将指针下移一个单位，将已有数量减一
+    pmsg = *pevent->OSQOut++;                    /* Extract oldest message from the queue              */
+    pevent->OSNMsgs--;                           /* Update the number of entries in the queue          */
+    if (pevent->OSQOut == pevent->OSQEnd) {      /* Wrap OUT pointer if we are at the end of the queue */
+        pevent->OSQOut = pevent->OSQStart;
+    }
+    return (pmsg);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     PEND ON A QUEUE FOR A MESSAGE
+*
+* Description: This function is INTERNAL to MinOS and is used by OSQPend() and OSQPendUs().
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+*
+*              timeout       is the timeout in clock ticks (0 if none)
+*
+*              us            is the timeout in microseconds (0 if none, always 0 unless OS_HRT_EN)
+*
+*              perr          is a pointer to where an error message will be deposited.
+*********************************************************************************************************
+*/
+
+static void  *OS_QPend (OS_EVENT *pevent, INT16U timeout, INT32U us, INT8U *perr)
+{
+    void      *pmsg;
+
+    OS_CPU_SR  cpu_sr = 0;
+
+#if OS_HRT_EN == 0
+    (void)us;                                    /* Only used by the high resolution timeouts          */
+#endif
+    if (OSIntNesting > 0) {                      /* See if called from ISR ...                         */
+        while(1);
+    }
+		
+    OS_ENTER_CRITICAL();
+    
+#if OS_STAT_EN > 0
+    pevent->OSEventPendCtr++;
+#endif
+    //消息队列中有现成的，直接返回结果，即若队列中有多个消息，该任务会一口气执行完所有消息再挂起
+    if (pevent->OSNMsgs > 0) {                    /* See if any messages in the queue                   */
+        
+        //正常出列
+        pmsg = OS_QGet(pevent);                  /* Yes, extract oldest message from the queue         */
+        OS_EXIT_CRITICAL();
+        *perr = OS_ERR_NONE;
+        return (pmsg);                           /* Return message received                            */
+    }
+    OS_TASK_BLOCK_CHK();
+    OSTCBCur->OSTCBStat     |= OS_STAT_PEND_Q;  //任务状态：正在等Q /* Task will have to pend for a message to be posted  */
+    OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK; //等待状态：正常等待
+    OSTCBCur->OSTCBDly       = timeout;          /* Load timeout into TCB                              */
+#if OS_STAT_EN > 0
+    OSTCBCur->OSTCBPendStart = OSTime;
+#endif
+    
+    //内部设置等待该事件的任务有哪些？有本任务！
+    // OS_EventTaskWait(pevent);                    /* Suspend task until event or timeout occurs         */
+    
+    OSTCBCur->OSTCBEventPtr      = pevent;                 /* Store ptr to ECB in TCB         */
+    pevent->OSEventWaitTbl          |=  ( 1<< OSTCBCur->OSTCBPrio );/* Put task in waiting list        */
+    OSRdyTbl                    &= ~( 1<< OSTCBCur->OSTCBPrio );/* Task no longer ready                              */
+#if OS_HRT_EN > 0
+    if (us > 0) {                                /* Load the high resolution timeout                   */
+        OS_HRTInsert(OSTCBCur, OS_HRTDeadline(us));
+    }
+#endif
+    
+    
+    OS_EXIT_CRITICAL();
+    OS_Sched(); 
+    
+    /////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////
+    //已跳出该任务。。。直至超时时间到或收到Q将返回继续执行
+                                     /* Find next highest priority task ready to run       */
+    OS_ENTER_CRITICAL();
+#if OS_HRT_EN > 0
+    OS_HRTRemove(OSTCBCur);                      /* Still linked if a message arrived in time          */
+#endif
+
+#if OS_STAT_EN > 0
+    if ((OSTime - OSTCBCur->OSTCBPendStart) > pevent->OSEventBlockMax) {
+        pevent->OSEventBlockMax = OSTime - OSTCBCur->OSTCBPendStart;
+    }
+    if (OSTCBCur->OSTCBStatPend != OS_STAT_PEND_OK) {
+        pevent->OSEventTOCtr++;
+    }
+#endif
+
+    //查看到底是超时还是确实收到Q了？
+    switch (OSTCBCur->OSTCBStatPend) {                /* See if we timed-out or aborted                */
+        //确实收到Q 了！
+        case OS_STAT_PEND_OK:                         /* Extract message from TCB (Put there by QPost) */
+             pmsg =  OSTCBCur->OSTCBMsg;
+            *perr =  OS_ERR_NONE;
+#if OS_Q_TRACE_EN > 0
+             OS_QTraceRecv(pevent, &OSTCBCur->OSTCBMsgTs);
+#endif
+             break;
+
+        //未收到Q，Pend超时了！
+        case OS_STAT_PEND_TO:
+        default:
+            //  OS_EventTaskRemove(OSTCBCur, pevent);
+             pevent->OSEventWaitTbl &= ~( 1 << OSTCBCur->OSTCBPrio ); /* Remove task from wait list                  */
+             pmsg = (void *)0;
+            *perr =  OS_ERR_TIMEOUT;                  /* Indicate that we didn't get event within TO   */
+             break;
+    }
+
+    //任务已就绪
+    OSTCBCur->OSTCBStat          =  OS_STAT_RDY;      /* Set   task  status to ready                   */
+    
+    //该次pend标志清除，下次pend重新设置
+    OSTCBCur->OSTCBStatPend      =  OS_STAT_PEND_OK;  /* Clear pend  status                            */
+    OSTCBCur->OSTCBEventPtr      = (OS_EVENT  *)0;    /* Clear event pointers                          */
+
+    //清除已收到的Msg，即已将消息地址扔出去（赋值给内部变量pmsg），该Event表中已无记录	
+    OSTCBCur->OSTCBMsg           = (void      *)0;    /* Clear  received message                       */
+    OS_EXIT_CRITICAL();
+    return (pmsg);                                    /* Return received message                       */
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     PEND ON A QUEUE FOR A MESSAGE
+*
+* Description: This function waits for a message to be sent to a queue
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+*
+*              timeout       is an optional timeout period (in clock ticks).  If non-zero, your task will
+*                            wait for a message to arrive at the queue up to the amount of time
+*                            specified by this argument.  If you specify 0, however, your task will wait
+*                            forever at the specified queue or, until a message arrives.
+*
+*              perr          is a pointer to where an error message will be deposited.  Possible error
+*                            messages are:
+*
+*                            OS_ERR_NONE         The call was successful and your task received a
+*                                                message.
+*                            OS_ERR_TIMEOUT      A message was not received within the specified 'timeout'.
+*
+*********************************************************************************************************
+*/
+
+void  *OSQPend (OS_EVENT *pevent, INT16U timeout, INT8U *perr)
+{
+    return (OS_QPend(pevent, timeout, 0, perr));
+}
+
+#if OS_HRT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                             PEND ON A QUEUE FOR A MESSAGE (MICROSECOND TIMEOUT)
+*
+* Description: This function is identical to OSQPend() but the timeout is given in microseconds and is
+*              timed by the high resolution timer instead of the tick.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+*
+*              us            is an optional timeout period in microseconds.  0 means wait forever.  Longer
+*                            timeouts than OS_HRT_US_MAX are clamped to OS_HRT_US_MAX.
+*
+*              perr          is a pointer to where an error message will be deposited (see OSQPend()).
+*********************************************************************************************************
+*/
+
+void  *OSQPendUs (OS_EVENT *pevent, INT32U us, INT8U *perr)
+{
+    return (OS_QPend(pevent, 0, us, perr));
+}
+#endif
+
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                  PEND ON SEVERAL QUEUES FOR A MESSAGE
+*
+* Description: This function waits for a message to be sent to any of several queues.  The task is put in
+*              the wait list of every queue; the first post readies it and the task is no longer seen as
+*              waiting by the other queues (OSQPost() skips and drops such stale wait list entries), so
+*              posting stays O(1).  The remaining wait list entries are removed when the task resumes.
+*
+* Arguments  : pevents       is an array of pointers to the queues to wait on
+*
+*              nevents       is the number of queues in 'pevents'
+*
+*              timeout       is an optional timeout period (in clock ticks).  If you specify 0, your task
+*                            will wait forever until a message arrives.
+*
+*              pwhich        is a pointer to where the index (in 'pevents') of the queue which delivered
+*                            the message will be deposited.  It is not modified on timeout.
+*
+*              perr          is a pointer to where an error message will be deposited.  Possible error
+*                            messages are:
+*
+*                            OS_ERR_NONE         The call was successful and your task received a
+*                                                message.
+*                            OS_ERR_TIMEOUT      A message was not received within the specified 'timeout'.
+*
+* Returns    : The message received or (void *)0 on timeout.
+*
+* Note(s)    : If several queues already hold messages, the first one in 'pevents' is served.
+*********************************************************************************************************
+*/
+
+void  *OSQPendAny (OS_EVENT **pevents, INT8U nevents, INT16U timeout, INT8U *pwhich, INT8U *perr)
+{
+    return (OS_QPendAny(pevents, nevents, timeout, 0, pwhich, perr));
+}
+
+#if OS_HRT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                          PEND ON SEVERAL QUEUES FOR A MESSAGE (MICROSECOND TIMEOUT)
+*
+* Description: This function is identical to OSQPendAny() but the timeout is given in microseconds (at
+*              most OS_HRT_US_MAX, 0 means wait forever) and is timed by the high resolution timer.
+*********************************************************************************************************
+*/
+
+void  *OSQPendAnyUs (OS_EVENT **pevents, INT8U nevents, INT32U us, INT8U *pwhich, INT8U *perr)
+{
+    return (OS_QPendAny(pevents, nevents, 0, us, pwhich, perr));
+}
+#endif
+
+/*
+*********************************************************************************************************
+*                                  PEND ON SEVERAL QUEUES FOR A MESSAGE
+*
+* Description: This function is INTERNAL to MinOS and is used by OSQPendAny() and OSQPendAnyUs().  The
+*              timeout is given either in ticks ('timeout') or in microseconds ('us').
+*********************************************************************************************************
+*/
+
+static void  *OS_QPendAny (OS_EVENT **pevents, INT8U nevents, INT16U timeout, INT32U us, INT8U *pwhich, INT8U *perr)
+{
+    void      *pmsg;
+    INT8U      i;
+    INT32U     bit;
+    OS_CPU_SR  cpu_sr = 0;
+
+#if OS_HRT_EN == 0
+    (void)us;
+#endif
+    if (OSIntNesting > 0) {                      /* See if called from ISR ...                         */
+        while(1);
+    }
+
+    bit = (INT32U)1 << OSTCBCur->OSTCBPrio;
+    OS_ENTER_CRITICAL();
+
+    for (i = 0; i < nevents; i++) {              /* See if any messages in one of the queues           */
+#if OS_STAT_EN > 0
+        pevents[i]->OSEventPendCtr++;
+#endif
+        if (pevents[i]->OSNMsgs > 0) {
+            pmsg = OS_QGet(pevents[i]);
+            OS_EXIT_CRITICAL();
+           *pwhich = i;
+           *perr   = OS_ERR_NONE;
+            return (pmsg);
+        }
+    }
+
+    OS_TASK_BLOCK_CHK();
+    OSTCBCur->OSTCBStat     |= OS_STAT_PEND_Q;   /* Task will have to pend for a message to be posted  */
+    OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK;
+    OSTCBCur->OSTCBDly       = timeout;          /* Load timeout into TCB                              */
+    OSTCBCur->OSTCBEventPtr  = (OS_EVENT *)0;    /* Set by OSQPost() to the queue which posted         */
+#if OS_STAT_EN > 0
+    OSTCBCur->OSTCBPendStart = OSTime;
+#endif
+    for (i = 0; i < nevents; i++) {              /* Put task in every waiting list                     */
+        pevents[i]->OSEventWaitTbl |= bit;
+    }
+    OSRdyTbl                &= ~bit;             /* Task no longer ready                               */
+#if OS_HRT_EN > 0
+    if (us > 0) {                                /* Load the high resolution timeout                   */
+        OS_HRTInsert(OSTCBCur, OS_HRTDeadline(us));
+    }
+#endif
+    OS_EXIT_CRITICAL();
+    OS_Sched();                                  /* Find next highest priority task ready to run       */
+    OS_ENTER_CRITICAL();
+#if OS_HRT_EN > 0
+    OS_HRTRemove(OSTCBCur);                      /* Still linked if a message arrived in time          */
+#endif
+
+    for (i = 0; i < nevents; i++) {              /* Remove task from every waiting list                */
+        pevents[i]->OSEventWaitTbl &= ~bit;
+        if (pevents[i] == OSTCBCur->OSTCBEventPtr) {
+           *pwhich = i;
+        }
+#if OS_STAT_EN > 0
+        if (OSTCBCur->OSTCBStatPend != OS_STAT_PEND_OK) {
+            pevents[i]->OSEventTOCtr++;
+        } else if ((pevents[i] == OSTCBCur->OSTCBEventPtr) &&
+                   ((OSTime - OSTCBCur->OSTCBPendStart) > pevents[i]->OSEventBlockMax)) {
+            pevents[i]->OSEventBlockMax = OSTime - OSTCBCur->OSTCBPendStart;
+        }
+#endif
+    }
+
+    if (OSTCBCur->OSTCBStatPend == OS_STAT_PEND_OK) {
+        pmsg  = OSTCBCur->OSTCBMsg;              /* Extract message from TCB (Put there by QPost)      */
+       *perr  = OS_ERR_NONE;
+#if OS_Q_TRACE_EN > 0
+        OS_QTraceRecv(OSTCBCur->OSTCBEventPtr, &OSTCBCur->OSTCBMsgTs);
+#endif
+    } else {
+        pmsg  = (void *)0;
+       *perr  = OS_ERR_TIMEOUT;                  /* Indicate that we didn't get event within TO        */
+    }
+    OSTCBCur->OSTCBStat      = OS_STAT_RDY;      /* Set   task  status to ready                        */
+    OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK;  /* Clear pend  status                                 */
+    OSTCBCur->OSTCBEventPtr  = (OS_EVENT  *)0;   /* Clear event pointers                               */
+    OSTCBCur->OSTCBMsg       = (void      *)0;   /* Clear  received message                            */
+    OS_EXIT_CRITICAL();
+    return (pmsg);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        POST MESSAGE TO A QUEUE
+*
+* Description: This function sends a message to the highest priority task waiting on a queue or, if no
+*              task is waiting, stores it in the queue.  This function is INTERNAL to MinOS, see
+*              OSQPost(), OSQPostFront() and OSQPostPrio().
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+*
+*              pmsg          is a pointer to the message to send.
+*
+*              level         is the message priority (priority queues only, 0 is the most urgent).
+*
+*              opt           determines the type of POST performed:
+*                            OS_POST_OPT_NONE         POST to the end of the queue (FIFO)
+*                            OS_POST_OPT_FRONT        POST to the front of the queue (LIFO)
+*                            OS_POST_OPT_BROADCAST    POST to ALL tasks that are waiting on the queue
+*
+* Returns    : OS_ERR_NONE           The call was successful and the message was sent
+*              OS_ERR_Q_FULL         If the queue cannot accept any more messages because it is full.
+*
+*********************************************************************************************************
+*/
+
+static INT8U  OS_QPost (OS_EVENT *pevent, void *pmsg, INT8U level, INT8U opt)
+{
+    OS_TCB  *ptcb;
+    INT8U    prio;
+    INT32U   waittbl;
+    INT32U   rdytbl;
+#if OS_Q_PRIO_EN > 0
+    OS_Q_PRIO  *pqprio;
+    OS_Q_MSG   *pentry;
+#endif
+#if OS_Q_TRACE_EN > 0
+    OS_Q_TS     ts;
+#endif
+    OS_CPU_SR  cpu_sr = 0;
+
+#if OS_Q_PRIO_EN == 0
+    (void)level;                                           /* Only used by priority queues             */
+#endif
+    OS_ENTER_CRITICAL();
+#if OS_Q_TRACE_EN > 0
+    OS_QTraceStamp(&ts);                                   /* Taken even if the queue is not traced        */
+#endif
+
+#if OS_STAT_EN > 0
+    pevent->OSEventPostCtr++;
+#endif
+    if ((opt & OS_POST_OPT_BROADCAST) != 0) {              /* Hand the message to every waiting task       */
+        waittbl                = pevent->OSEventWaitTbl;
+        rdytbl                 = 0;
+        pevent->OSEventWaitTbl = 0;                        /* Remove all tasks from wait list              */
+        while (waittbl != 0) {
+            prio     = (INT8U) CPU_CntTrailZeros( waittbl );
+            waittbl &= ~( 1u << prio );
+            ptcb     = &OSTCBTbl[prio];
+            if ((ptcb->OSTCBStat & OS_STAT_PEND_Q) == 0) {  /* Skip stale entries, see OSQPendAny()         */
+                continue;
+            }
+            ptcb->OSTCBDly       =  0;
+            ptcb->OSTCBMsg       =  pmsg;
+            ptcb->OSTCBEventPtr  =  pevent;
+#if OS_Q_TRACE_EN > 0
+            ptcb->OSTCBMsgTs     =  ts;
+#endif
+            ptcb->OSTCBStat     &= ~OS_STAT_PEND_Q;
+            ptcb->OSTCBStatPend  =  OS_STAT_PEND_OK;
+            if (ptcb->OSTCBStat == OS_STAT_RDY) {
+                rdytbl |= ( 1u << prio );
+                OS_TASK_RDY_MARK(ptcb);
+            }
+#if OS_STAT_EN > 0
+            pevent->OSEventHandoffCtr++;
+#endif
+        }
+        if (rdytbl != 0) {
+            OSRdyTbl |= rdytbl;                            /* Make all of them ready at once               */
+            OS_EXIT_CRITICAL();
+            OS_Sched();                                    /* One reschedule for all the tasks readied     */
+            return (OS_ERR_NONE);
+        }
+    }
+
+    //有任务正在等待该Q！
+    //若中断中连续Post会出现覆盖？不会入列？YES!
+    while (pevent->OSEventWaitTbl != 0) {                  /* See if any task pending on queue             */
+                                                       /* Ready highest priority task waiting on event */
+        //该次Post只会喂饱一个任务（即等待该事件的任务中优先级最高的那个）
+        // OS_EventTaskRdy(pevent, pmsg);
+
+                                                        /* Find HPT waiting for message                */
+        prio                  = (INT8U) CPU_CntTrailZeros( pevent-> OSEventWaitTbl );
+
+        ptcb                  =  &OSTCBTbl[prio];        /* Point to this task's OS_TCB                 */
+
+        // OS_EventTaskRemove(ptcb, pevent);                   /* Remove this task from event   wait list     */
+        pevent->OSEventWaitTbl &= ~( 1 << prio );           /* Remove task from wait list                  */
+        if ((ptcb->OSTCBStat & OS_STAT_PEND_Q) == 0) {      /* Stale entry: task was readied by another    */
+            continue;                                       /* ... queue (OSQPendAny()) or timed out       */
+        }
+
+        ptcb->OSTCBDly        =  0;                         /* Prevent OSTimeTick() from readying task     */
+            
+        ptcb->OSTCBMsg        =  pmsg;                      /* Send message directly to waiting task       */
+        ptcb->OSTCBEventPtr   =  pevent;                    /* Tell OSQPendAny() which queue posted        */
+#if OS_Q_TRACE_EN > 0
+        ptcb->OSTCBMsgTs      =  ts;
+#endif
+            
+        ptcb->OSTCBStat      &= ~OS_STAT_PEND_Q;//若该任务只是在等待Q，则此语句相当于将任务就绪了                       /* Clear bit associated with event type        */
+        ptcb->OSTCBStatPend   =  OS_STAT_PEND_OK;                 /* Set pend status of post or abort            */
+                                                            /* See if task is ready (could be susp'd)      */
+        if (ptcb->OSTCBStat == OS_STAT_RDY) {
+            OSRdyTbl |= ( 1 << ptcb->OSTCBPrio );           /* Put task in the ready to run list           */
+            OS_TASK_RDY_MARK(ptcb);
+        }
+#if OS_STAT_EN > 0
+        pevent->OSEventHandoffCtr++;
+#endif
+
+        OS_EXIT_CRITICAL();
+        OS_Sched();//若在中断中Post该调度将无效，将在中断退出时（OSIntExit）执行有效调度，前提是无中断嵌套                                    /* Find highest priority task ready to run      */
+        return (OS_ERR_NONE);
+    }
+    
+    if (pevent->OSNMsgs >= pevent->OSQSize) {               /* Make sure queue is not full                  */
+        OS_EXIT_CRITICAL();
+        while(1);//  OS_ERR_Q_FULL 消息队列已满，需增大数组
+    }
+
+    //正常入列
+#if OS_Q_PRIO_EN > 0
+    if (pevent->OSEventType == OS_EVENT_TYPE_Q_PRIO) {     /* Append to the list of the message priority   */
+        pqprio                  = (OS_Q_PRIO *)pevent->OSEventPtr;
+        pentry                  = pqprio->OSQPrioFreeList;
+        pqprio->OSQPrioFreeList = pentry->OSQMsgNext;
+        pentry->OSQMsgPtr       = pmsg;
+#if OS_Q_TRACE_EN > 0
+        pentry->OSQMsgTs        = ts;
+#endif
+        if (pqprio->OSQPrioHead[level] == (OS_Q_MSG *)0) { /* First message of this level                  */
+            pentry->OSQMsgNext          = (OS_Q_MSG *)0;
+            pqprio->OSQPrioHead[level]  = pentry;
+            pqprio->OSQPrioTail[level]  = pentry;
+            pqprio->OSQPrioRdyTbl      |= ( 1u << level );
+        } else if ((opt & OS_POST_OPT_FRONT) != 0) {
+            pentry->OSQMsgNext          = pqprio->OSQPrioHead[level];
+            pqprio->OSQPrioHead[level]  = pentry;
+        } else {
+            pentry->OSQMsgNext          = (OS_Q_MSG *)0;
+            pqprio->OSQPrioTail[level]->OSQMsgNext = pentry;
+            pqprio->OSQPrioTail[level]  = pentry;
+        }
+    } else
+#endif
+    if ((opt & OS_POST_OPT_FRONT) != 0) {                  /* Insert message before the oldest one         */
+        if (pevent->OSQOut == pevent->OSQStart) {          /* Wrap OUT ptr if we are at the 1st queue entry*/
+            pevent->OSQOut = pevent->OSQEnd;
+        }
+        *--pevent->OSQOut = pmsg;
+#if OS_Q_TRACE_EN > 0
+        if (pevent->OSQTraceOn != 0) {
+            pevent->OSQTraceTs[pevent->OSQOut - pevent->OSQStart] = ts;
+        }
+#endif
+    } else {
+#if OS_Q_TRACE_EN > 0
+        if (pevent->OSQTraceOn != 0) {
+            pevent->OSQTraceTs[pevent->OSQIn - pevent->OSQStart]  = ts;
+        }
+#endif
+        *pevent->OSQIn++ = pmsg;                           /* Insert message into queue                    */
+        if (pevent->OSQIn == pevent->OSQEnd) {             /* Wrap IN ptr if we are at end of queue        */
+            pevent->OSQIn = pevent->OSQStart;
+        }
+    }
+    pevent->OSNMsgs++;                                  /* Update the nbr of entries in the queue       */
+#if OS_STAT_EN > 0
+    if (pevent->OSNMsgs > pevent->OSNMsgsPeak) {           /* Track the queue high-water mark              */
+        pevent->OSNMsgsPeak = pevent->OSNMsgs;
+    }
+#endif
+    OS_EXIT_CRITICAL();
+    return (OS_ERR_NONE);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        POST MESSAGE TO A QUEUE
+*
+* Description: This function sends a message to a queue.  On a priority queue the message gets the
+*              lowest priority (OS_Q_PRIO_LOWEST).
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+*
+*              pmsg          is a pointer to the message to send.
+*
+* Returns    : OS_ERR_NONE           The call was successful and the message was sent
+*              OS_ERR_Q_FULL         If the queue cannot accept any more messages because it is full.
+*
+*********************************************************************************************************
+*/
+
+INT8U  OSQPost (OS_EVENT *pevent, void *pmsg)
+{
+    return (OS_QPost(pevent, pmsg, OS_Q_PRIO_LOWEST, OS_POST_OPT_NONE));
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                   POST MESSAGE TO THE FRONT OF A QUEUE
+*
+* Description: This function sends a message to a queue but unlike OSQPost(), the message is posted at
+*              the front instead of the end of the queue: it will be the next message extracted.  Use it
+*              for 'urgent' messages.  On a priority queue the message goes in front of the most urgent
+*              priority level.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+*
+*              pmsg          is a pointer to the message to send.
+*
+* Returns    : OS_ERR_NONE           The call was successful and the message was sent
+*              OS_ERR_Q_FULL         If the queue cannot accept any more messages because it is full.
+*
+*********************************************************************************************************
+*/
+
+INT8U  OSQPostFront (OS_EVENT *pevent, void *pmsg)
+{
+    return (OS_QPost(pevent, pmsg, 0, OS_POST_OPT_FRONT));
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        POST MESSAGE TO A QUEUE
+*
+* Description: This function sends a message to a queue.  This call has been added to reduce code size
+*              since it can replace both OSQPost() and OSQPostFront().  Also, this function adds the
+*              capability to broadcast a message to ALL tasks waiting on the message queue: the tasks
+*              are readied together and the scheduler runs only once.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+*
+*              pmsg          is a pointer to the message to send.
+*
+*              opt           determines the type of POST performed:
+*                            OS_POST_OPT_NONE         POST to the end of the queue (FIFO)
+*                            OS_POST_OPT_FRONT        POST to the front of the queue (LIFO)
+*                            OS_POST_OPT_BROADCAST    POST to ALL tasks that are waiting on the queue
+*
+*                            Below is a list of ALL the possible combination of these flags:
+*
+*                                 1) OS_POST_OPT_NONE
+*                                    identical to OSQPost()
+*
+*                                 2) OS_POST_OPT_FRONT
+*                                    identical to OSQPostFront()
+*
+*                                 3) OS_POST_OPT_BROADCAST
+*                                    identical to OSQPost() but will broadcast 'pmsg' to ALL waiting tasks
+*
+*                                 4) OS_POST_OPT_FRONT + OS_POST_OPT_BROADCAST  is identical to
+*                                    OSQPostFront() except that will broadcast 'pmsg' to ALL waiting tasks
+*
+* Returns    : OS_ERR_NONE           The call was successful and the message was sent
+*              OS_ERR_Q_FULL         If the queue cannot accept any more messages because it is full.
+*
+* Note(s)    : The message is stored in the queue only if no task was waiting.
+*
+*********************************************************************************************************
+*/
+
+INT8U  OSQPostOpt (OS_EVENT *pevent, void *pmsg, INT8U opt)
+{
+    if ((opt & OS_POST_OPT_FRONT) != 0) {
+        return (OS_QPost(pevent, pmsg, 0, opt));
+    }
+    return (OS_QPost(pevent, pmsg, OS_Q_PRIO_LOWEST, opt));
+}
+
+#if OS_Q_PRIO_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                      CREATE A PRIORITY MESSAGE QUEUE
+*
+* Description: This function creates a queue in which every message carries a priority.  OSQPend() always
+*              returns the oldest message of the most urgent priority.  Messages of each priority are
+*              linked in their own FIFO and a bitmap of the non-empty priorities finds the most urgent one
+*              with a single count-trailing-zeros, so posting and pending stay O(1).
+*
+* Arguments  : pqprio        is a pointer to the priority queue control structure
+*
+*              start         is a pointer to the message entries storage area.  The storage area MUST be
+*                            declared as follows:
+*
+*                            OS_Q_MSG MessageStorage[size]
+*
+*              size          is the number of elements in the storage area
+*
+* Returns    : != (OS_EVENT *)0  is a pointer to the event control clock (OS_EVENT) associated with the
+*                                created queue
+*              == (OS_EVENT *)0  if no event control blocks were available or an error was detected
+*********************************************************************************************************
+*/
+
+OS_EVENT  *OSQPrioCreate (OS_Q_PRIO *pqprio, OS_Q_MSG *start, INT16U size)
+{
+    OS_EVENT  *pevent;
+    INT16U     i;
+
+    pqprio->OSQPrioRdyTbl   = 0;
+    pqprio->OSQPrioFreeList = (OS_Q_MSG *)0;
+    for (i = 0; i < OS_Q_PRIO_LVLS; i++) {
+        pqprio->OSQPrioHead[i] = (OS_Q_MSG *)0;
+        pqprio->OSQPrioTail[i] = (OS_Q_MSG *)0;
+    }
+    for (i = 0; i < size; i++) {                          /* Link all entries in the free list         */
+        start[i].OSQMsgNext     = pqprio->OSQPrioFreeList;
+        pqprio->OSQPrioFreeList = &start[i];
+    }
+
+    pevent = OSQCreate((void **)0, 0);                    /* Get an ECB, ring pointers are not used    */
+    pevent->OSQSize     = size;
+    pevent->OSEventPtr  = pqprio;
+    pevent->OSEventType = OS_EVENT_TYPE_Q_PRIO;
+    return (pevent);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                 POST MESSAGE WITH A PRIORITY TO A QUEUE
+*
+* Description: This function sends a message with a priority to a priority queue.
+*
+* Arguments  : pevent        is a pointer to the event control block of a queue created by OSQPrioCreate()
+*
+*              pmsg          is a pointer to the message to send.
+*
+*              prio          is the message priority, 0 (most urgent) to OS_Q_PRIO_LOWEST.
+*
+* Returns    : OS_ERR_NONE           The call was successful and the message was sent
+*              OS_ERR_Q_FULL         If the queue cannot accept any more messages because it is full.
+*
+*********************************************************************************************************
+*/
+
+INT8U  OSQPostPrio (OS_EVENT *pevent, void *pmsg, INT8U prio)
+{
+    if (prio > OS_Q_PRIO_LOWEST) {
+        prio = OS_Q_PRIO_LOWEST;
+    }
+    return (OS_QPost(pevent, pmsg, prio, OS_POST_OPT_NONE));
+}
+#endif
+
+#if OS_STAT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                      ITERATE OVER THE LIVE QUEUES
+*
+* Description: This function returns the queue created after 'pevent' and takes a consistent snapshot of
+*              its counters, so that a diagnostics task can walk all queues:
+*
+*                           pevent = OSEventNext((OS_EVENT *)0, &data);
+*                           while (pevent != (OS_EVENT *)0) {
+*                               Send 'data';
+*                               pevent = OSEventNext(pevent, &data);
+*                           }
+*
+* Arguments  : pevent        is the queue returned by the previous call, (OS_EVENT *)0 to start
+*
+*              pdata         is a pointer to where the snapshot will be deposited
+*
+* Returns    : != (OS_EVENT *)0  is a pointer to the next live queue
+*              == (OS_EVENT *)0  if there is no more queue
+*********************************************************************************************************
+*/
+
+OS_EVENT  *OSEventNext (OS_EVENT *pevent, OS_EVENT_DATA *pdata)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (pevent == (OS_EVENT *)0) {
+        pevent = &OSEventTbl[0];
+    } else {
+        pevent++;
+    }
+
+    OS_ENTER_CRITICAL();
+    while (pevent < &OSEventTbl[OS_MAX_QS]) {
+        if (pevent->OSEventType != OS_EVENT_TYPE_UNUSED) {
+            pdata->OSEventPtr        = pevent;
+            pdata->OSEventWaitTbl    = pevent->OSEventWaitTbl;
+            pdata->OSQSize           = pevent->OSQSize;
+            pdata->OSNMsgs           = pevent->OSNMsgs;
+            pdata->OSNMsgsPeak       = pevent->OSNMsgsPeak;
+            pdata->OSEventPostCtr    = pevent->OSEventPostCtr;
+            pdata->OSEventPendCtr    = pevent->OSEventPendCtr;
+            pdata->OSEventTOCtr      = pevent->OSEventTOCtr;
+            pdata->OSEventHandoffCtr = pevent->OSEventHandoffCtr;
+            pdata->OSEventBlockMax   = pevent->OSEventBlockMax;
+            OS_EXIT_CRITICAL();
+            return (pevent);
+        }
+        pevent++;
+    }
+    OS_EXIT_CRITICAL();
+    return ((OS_EVENT *)0);
+}
+#endif
+
+#if OS_Q_TRACE_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        START TRACING A QUEUE
+*
+* Description: This function starts tracing the messages posted to a queue and clears its counters.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the queue
+*
+*              pts           is a pointer to the timestamps storage area, parallel to the message storage
+*                            area given to OSQCreate().  It MUST be declared as follows:
+*
+*                            OS_Q_TS TimestampStorage[size]
+*
+*                            Priority queues keep the timestamps in their OS_Q_MSG entries, pass
+*                            (OS_Q_TS *)0.
+*
+* Returns    : none
+*
+* Note(s)    : Call it before messages are posted to the queue.
+*********************************************************************************************************
+*/
+
+void  OSQTraceStart (OS_EVENT *pevent, OS_Q_TS *pts)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if ((pevent->OSEventType == OS_EVENT_TYPE_Q) && (pts == (OS_Q_TS *)0)) {
+        while(1);                                /* A ring needs its timestamps storage                */
+    }
+    OS_ENTER_CRITICAL();
+    pevent->OSQTraceTs     = pts;
+    pevent->OSQTraceCtr    = 0;
+    pevent->OSQTraceResMin = 0xFFFFFFFFu;
+    pevent->OSQTraceResMax = 0;
+    pevent->OSQTraceResSum = 0;
+    pevent->OSQTraceE2EMin = 0xFFFFFFFFu;
+    pevent->OSQTraceE2EMax = 0;
+    pevent->OSQTraceE2ESum = 0;
+    pevent->OSQTraceOn     = 1u;
+    OS_EXIT_CRITICAL();
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                       TIMESTAMP A POSTED MESSAGE
+*
+* Description: This function takes the timestamps of a message being posted.  The flow is started unless
+*              the poster is a task carrying the start of the flow of the last message it received.  It
+*              MUST be called with interrupts disabled.  This function is INTERNAL to MinOS.
+*
+* Arguments  : pts           is a pointer to where the timestamps will be deposited
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_QTraceStamp (OS_Q_TS *pts)
+{
+    pts->OSQTsEnq = OS_TS_GET();
+    if ((OSIntNesting == 0) && (OSTCBCur != (OS_TCB *)0) &&
+        ((OSQTraceSrcTbl & (1u << OSTCBCur->OSTCBPrio)) != 0)) {
+        pts->OSQTsSrc = OSTCBCur->OSTCBTraceSrc;          /* Posted on behalf of an earlier message     */
+    } else {
+        pts->OSQTsSrc = pts->OSQTsEnq;                    /* New flow                                   */
+    }
+}
+
+/*
+*********************************************************************************************************
+*                                       ACCOUNT A RECEIVED MESSAGE
+*
+* Description: This function accounts the latencies of a message received by the current task and makes
+*              the task carry the start of its flow.  A message from a queue which is not traced ends the
+*              flow.  It MUST be called with interrupts disabled.  This function is INTERNAL to MinOS.
+*
+* Arguments  : pevent        is a pointer to the queue the message was received from
+*
+*              pts           is a pointer to the timestamps of the message
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_QTraceRecv (OS_EVENT *pevent, OS_Q_TS *pts)
+{
+    INT32U  now;
+    INT32U  res;
+    INT32U  e2e;
+
+    if (pevent->OSQTraceOn == 0) {
+        OSQTraceSrcTbl &= ~( 1u << OSTCBCur->OSTCBPrio );
+        return;
+    }
+    now = OS_TS_GET();
+    res = now - pts->OSQTsEnq;
+    e2e = now - pts->OSQTsSrc;
+    pevent->OSQTraceCtr++;
+    pevent->OSQTraceResSum += res;
+    pevent->OSQTraceE2ESum += e2e;
+    if (res < pevent->OSQTraceResMin) {
+        pevent->OSQTraceResMin = res;
+    }
+    if (res > pevent->OSQTraceResMax) {
+        pevent->OSQTraceResMax = res;
+    }
+    if (e2e < pevent->OSQTraceE2EMin) {
+        pevent->OSQTraceE2EMin = e2e;
+    }
+    if (e2e > pevent->OSQTraceE2EMax) {
+        pevent->OSQTraceE2EMax = e2e;
+    }
+    OSTCBCur->OSTCBTraceSrc = pts->OSQTsSrc;
+    OSQTraceSrcTbl         |= ( 1u << OSTCBCur->OSTCBPrio );
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                       GET THE LATENCIES OF A QUEUE
+*
+* Description: This function returns the residence and end-to-end latencies measured on a queue.
+*
+* Arguments  : pevent        is a pointer to the event control block associated with the queue
+*
+*              pdata         is a pointer to where the latencies will be deposited.  Minimums are 0 when
+*                            no message was traced.
+*
+*              reset         1 to clear the counters once read
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSQTraceQuery (OS_EVENT *pevent, OS_Q_TRACE_DATA *pdata, INT8U reset)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    OS_ENTER_CRITICAL();
+    pdata->OSQTraceCtr = pevent->OSQTraceCtr;
+    if (pevent->OSQTraceCtr == 0) {
+        pdata->OSQTraceResMin = 0;
+        pdata->OSQTraceResAvg = 0;
+        pdata->OSQTraceResMax = 0;
+        pdata->OSQTraceE2EMin = 0;
+        pdata->OSQTraceE2EAvg = 0;
+        pdata->OSQTraceE2EMax = 0;
+    } else {
+        pdata->OSQTraceResMin = pevent->OSQTraceResMin;
+        pdata->OSQTraceResAvg = (INT32U)(pevent->OSQTraceResSum / pevent->OSQTraceCtr);
+        pdata->OSQTraceResMax = pevent->OSQTraceResMax;
+        pdata->OSQTraceE2EMin = pevent->OSQTraceE2EMin;
+        pdata->OSQTraceE2EAvg = (INT32U)(pevent->OSQTraceE2ESum / pevent->OSQTraceCtr);
+        pdata->OSQTraceE2EMax = pevent->OSQTraceE2EMax;
+    }
+    if (reset != 0) {
+        pevent->OSQTraceCtr    = 0;
+        pevent->OSQTraceResMin = 0xFFFFFFFFu;
+        pevent->OSQTraceResMax = 0;
+        pevent->OSQTraceResSum = 0;
+        pevent->OSQTraceE2EMin = 0xFFFFFFFFu;
+        pevent->OSQTraceE2EMax = 0;
+        pevent->OSQTraceE2ESum = 0;
+    }
+    OS_EXIT_CRITICAL();
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     GET THE LATENCIES OF A PIPELINE
+*
+* Description: This function aggregates the queues of a pipeline, from the source to the sink:
+*
+*                  ISR --> Parser_Q --> Parser --> Filter_Q --> Filter --> Log_Q --> Logger
+*
+*                  OS_EVENT *hops[] = { Parser_Q, Filter_Q, Log_Q };
+*                  OSQTracePipeline(hops, 3, &data);
+*
+*              The residences are summed over the queues: this is the share of the latency spent waiting
+*              in queues, the rest is spent running the stages.  The end-to-end latency and the count are
+*              the ones of the last queue, from the source to the sink.
+*
+*              The summed average is exact, but the summed minimum and maximum are only bounds of the
+*              residence of one message: the minimum of each queue is not reached by the same message, and
+*              neither is the maximum.  Only OSQTraceE2EMin and OSQTraceE2EMax are observed end to end.
+*
+* Arguments  : pevents       is an array of pointers to the queues, in the order of the pipeline
+*
+*              nevents       is the number of queues in 'pevents'.  0 deposits all zeros.
+*
+*              pdata         is a pointer to where the latencies will be deposited
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSQTracePipeline (OS_EVENT **pevents, INT8U nevents, OS_Q_TRACE_DATA *pdata)
+{
+    OS_Q_TRACE_DATA  hop;
+    INT8U            i;
+
+    if (nevents == 0) {                          /* Empty pipeline, nothing traced                     */
+        memset(pdata, 0, sizeof(OS_Q_TRACE_DATA));
+        return;
+    }
+    pdata->OSQTraceResMin = 0;
+    pdata->OSQTraceResAvg = 0;
+    pdata->OSQTraceResMax = 0;
+    for (i = 0; i < nevents; i++) {
+        OSQTraceQuery(pevents[i], &hop, 0);
+        pdata->OSQTraceResMin += hop.OSQTraceResMin;
+        pdata->OSQTraceResAvg += hop.OSQTraceResAvg;
+        pdata->OSQTraceResMax += hop.OSQTraceResMax;
+    }
+    pdata->OSQTraceCtr    = hop.OSQTraceCtr;     /* Sink                                               */
+    pdata->OSQTraceE2EMin = hop.OSQTraceE2EMin;
+    pdata->OSQTraceE2EAvg = hop.OSQTraceE2EAvg;
+    pdata->OSQTraceE2EMax = hop.OSQTraceE2EMax;
+}
+#endif
+
+#endif
+
+#if OS_IPC_EN > 0
+                                                 /* Head, tail and slots each start a cache line       */
+typedef char OS_IPC_CHK_TAIL[((offsetof(OS_IPC_SHM, OSIPCTail) % OS_IPC_CACHE_LINE) == 0) ? 1 : -1];
+typedef char OS_IPC_CHK_SLOT[((offsetof(OS_IPC_SHM, OSIPCSlot) % OS_IPC_CACHE_LINE) == 0) ? 1 : -1];
+typedef char OS_IPC_CHK_SIZE[((sizeof(OS_IPC_SHM) % OS_IPC_CACHE_LINE) == 0) ? 1 : -1];
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                 OPEN AN END OF AN INTER-PROCESSOR CHANNEL
+*
+* Description: This function opens the producer or the consumer end of a channel on this processor.
+*
+* Arguments  : pshm          is a pointer to the ring in shared memory
+*
+*              id            is the channel number passed to OS_IPC_Doorbell() (producer end only)
+*
+*              type          OS_EVENT_TYPE_IPC_TX  to open the producer end (resets the ring)
+*                            OS_EVENT_TYPE_IPC_RX  to open the consumer end
+*
+* Returns    : A pointer to the event control block of this end of the channel.
+*********************************************************************************************************
+*/
+
+OS_EVENT  *OSIPCCreate (OS_IPC_SHM *pshm, INT8U id, INT8U type)
+{
+    OS_EVENT  *pevent;
+
+    if ((type != OS_EVENT_TYPE_IPC_TX) && (type != OS_EVENT_TYPE_IPC_RX)) {
+        while(1);
+    }
+    if (type == OS_EVENT_TYPE_IPC_TX) {
+        pshm->OSIPCHead = 0;
+        pshm->OSIPCTail = 0;
+        pshm->OSIPCId   = id;
+        __DMB();                                 /* Ring reset before any message is committed         */
+    }
+    pevent              = OSQCreate((void **)0, 0);   /* Get an ECB, OSNMsgs counts uncommitted messages*/
+    pevent->OSEventPtr  = pshm;
+    pevent->OSQSize     = OS_IPC_SLOTS;
+    pevent->OSEventType = type;
+    return (pevent);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                 WRITE/COMMIT MESSAGES TO A CHANNEL
+*
+* Description: OSIPCWrite() stores a message in the ring without publishing it.  OSIPCCommit() publishes
+*              all the messages written since the last commit at once, then rings the doorbell of the
+*              peer.  OSIPCPost() writes and commits a single message.
+*
+* Arguments  : pevent        is a pointer to the producer end of the channel
+*
+*              pmsg          is the message to send
+*
+* Returns    : OS_ERR_NONE           The message was written
+*              OS_ERR_Q_FULL         The ring is full, the consumer is late
+*
+* Note(s)    : Only ONE task (or ISR) may write to a channel.  No critical section is used.
+*********************************************************************************************************
+*/
+
+INT8U  OSIPCWrite (OS_EVENT *pevent, void *pmsg)
+{
+    OS_IPC_SHM  *pshm;
+    INT32U       head;
+
+    pshm = (OS_IPC_SHM *)pevent->OSEventPtr;
+    head = pshm->OSIPCHead + pevent->OSNMsgs;    /* Next slot, uncommitted messages included           */
+    if ((head - pshm->OSIPCTail) >= OS_IPC_SLOTS) {
+        return (OS_ERR_Q_FULL);
+    }
+    pshm->OSIPCSlot[head & (OS_IPC_SLOTS - 1u)] = pmsg;
+    pevent->OSNMsgs++;
+    return (OS_ERR_NONE);
+}
+
+void  OSIPCCommit (OS_EVENT *pevent)
+{
+    OS_IPC_SHM  *pshm;
+
+    if (pevent->OSNMsgs == 0) {
+        return;
+    }
+    pshm = (OS_IPC_SHM *)pevent->OSEventPtr;
+    __DMB();                                     /* Messages visible before the head that covers them  */
+    pshm->OSIPCHead += pevent->OSNMsgs;
+    pevent->OSNMsgs  = 0;
+    __DMB();                                     /* Head visible before the peer is interrupted        */
+    OS_IPC_Doorbell(pshm->OSIPCId);
+}
+
+INT8U  OSIPCPost (OS_EVENT *pevent, void *pmsg)
+{
+    INT8U  err;
+
+    err = OSIPCWrite(pevent, pmsg);
+    if (err == OS_ERR_NONE) {
+        OSIPCCommit(pevent);
+    }
+    return (err);
+}
+
+/*
+*********************************************************************************************************
+*                                    EXTRACT A MESSAGE FROM A CHANNEL
+*
+* Description: This function takes the oldest message of a channel which is not empty.  It MUST be called
+*              with interrupts disabled.  This function is INTERNAL to MinOS.
+*********************************************************************************************************
+*/
+
+static void  *OS_IPCGet (OS_IPC_SHM *pshm)
+{
+    void    *pmsg;
+    INT32U   tail;
+
+    tail = pshm->OSIPCTail;
+    __DMB();                                     /* Slot read after the head covering it was seen      */
+    pmsg = pshm->OSIPCSlot[tail & (OS_IPC_SLOTS - 1u)];
+    __DMB();                                     /* Slot read before it is given back to the producer  */
+    pshm->OSIPCTail = tail + 1u;
+    return (pmsg);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                   PEND ON A CHANNEL FOR A MESSAGE
+*
+* Description: This function waits for a message on the consumer end of a channel.
+*
+* Arguments  : pevent        is a pointer to the consumer end of the channel
+*
+*              timeout       is an optional timeout period (in clock ticks).  0 means wait forever.
+*
+*              perr          is a pointer to where an error message will be deposited:
+*                            OS_ERR_NONE         The call was successful and your task received a message.
+*                            OS_ERR_TIMEOUT      A message was not received within the specified 'timeout'.
+*
+* Returns    : The message received or, a NULL pointer on timeout.
+*********************************************************************************************************
+*/
+
+void  *OSIPCPend (OS_EVENT *pevent, INT16U timeout, INT8U *perr)
+{
+    return (OS_IPCPend(pevent, timeout, 0, perr));
+}
+
+#if OS_HRT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                              PEND ON A CHANNEL FOR A MESSAGE (MICROSECOND TIMEOUT)
+*
+* Description: This function is identical to OSIPCPend() but the timeout is given in microseconds (at
+*              most OS_HRT_US_MAX, 0 means wait forever) and is timed by the high resolution timer.
+*********************************************************************************************************
+*/
+
+void  *OSIPCPendUs (OS_EVENT *pevent, INT32U us, INT8U *perr)
+{
+    return (OS_IPCPend(pevent, 0, us, perr));
+}
+#endif
+
+/*
+*********************************************************************************************************
+*                                   PEND ON A CHANNEL FOR A MESSAGE
+*
+* Description: This function is INTERNAL to MinOS and is used by OSIPCPend() and OSIPCPendUs().  The
+*              timeout is given either in ticks ('timeout') or in microseconds ('us').
+*********************************************************************************************************
+*/
+
+static void  *OS_IPCPend (OS_EVENT *pevent, INT16U timeout, INT32U us, INT8U *perr)
+{
+    OS_IPC_SHM  *pshm;
+    void        *pmsg;
+    OS_CPU_SR    cpu_sr = 0;
+
+#if OS_HRT_EN == 0
+    (void)us;
+#endif
+    if (OSIntNesting > 0) {                      /* See if called from ISR ...                         */
+        while(1);
+    }
+    pshm = (OS_IPC_SHM *)pevent->OSEventPtr;
+
+    OS_ENTER_CRITICAL();
+    if (pshm->OSIPCHead != pshm->OSIPCTail) {    /* Messages committed, no need to wait                */
+        pmsg = OS_IPCGet(pshm);
+        OS_EXIT_CRITICAL();
+        *perr = OS_ERR_NONE;
+        return (pmsg);
+    }
+    OS_TASK_BLOCK_CHK();
+    OSTCBCur->OSTCBStat     |= OS_STAT_PEND_Q;   /* Wait for OSIPCNotify()                             */
+    OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK;
+    OSTCBCur->OSTCBDly       = timeout;
+    OSTCBCur->OSTCBEventPtr  = pevent;
+    pevent->OSEventWaitTbl  |=  ( 1 << OSTCBCur->OSTCBPrio );
+    OSRdyTbl                &= ~( 1 << OSTCBCur->OSTCBPrio );
+#if OS_HRT_EN > 0
+    if (us > 0) {                                /* Load the high resolution timeout                   */
+        OS_HRTInsert(OSTCBCur, OS_HRTDeadline(us));
+    }
+#endif
+    OS_EXIT_CRITICAL();
+    OS_Sched();
+
+    OS_ENTER_CRITICAL();
+#if OS_HRT_EN > 0
+    OS_HRTRemove(OSTCBCur);                      /* Still linked if a message arrived in time          */
+#endif
+    if (OSTCBCur->OSTCBStatPend == OS_STAT_PEND_OK) {
+        pmsg  = OSTCBCur->OSTCBMsg;
+        *perr = OS_ERR_NONE;
+    } else {
+        pevent->OSEventWaitTbl &= ~( 1 << OSTCBCur->OSTCBPrio );
+        pmsg  = (void *)0;
+        *perr = OS_ERR_TIMEOUT;
+    }
+    OSTCBCur->OSTCBStat      =  OS_STAT_RDY;
+    OSTCBCur->OSTCBStatPend  =  OS_STAT_PEND_OK;
+    OSTCBCur->OSTCBEventPtr  = (OS_EVENT *)0;
+    OSTCBCur->OSTCBMsg       = (void     *)0;
+    OS_EXIT_CRITICAL();
+    return (pmsg);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                      PROCESS A CHANNEL DOORBELL
+*
+* Description: This function MUST be called by the doorbell ISR of the consumer processor (it can also be
+*              called by a task polling the channel).  Each task waiting on the channel gets one of the
+*              committed messages, highest priority first.
+*
+* Arguments  : pevent        is a pointer to the consumer end of the channel
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSIPCNotify (OS_EVENT *pevent)
+{
+    OS_IPC_SHM  *pshm;
+    OS_TCB      *ptcb;
+    INT8U        prio;
+    OS_CPU_SR    cpu_sr = 0;
+
+    pshm = (OS_IPC_SHM *)pevent->OSEventPtr;
+
+    OS_ENTER_CRITICAL();
+    while ((pevent->OSEventWaitTbl != 0) &&
+           (pshm->OSIPCHead != pshm->OSIPCTail)) {
+        prio                    = (INT8U) CPU_CntTrailZeros( pevent->OSEventWaitTbl );
+        ptcb                    = &OSTCBTbl[prio];
+        pevent->OSEventWaitTbl &= ~( 1 << prio );
+        if ((ptcb->OSTCBStat & OS_STAT_PEND_Q) == 0) {
+            continue;                            /* Timed out meanwhile                                */
+        }
+        ptcb->OSTCBDly          =  0;
+        ptcb->OSTCBMsg          =  OS_IPCGet(pshm);
+        ptcb->OSTCBStat        &= ~OS_STAT_PEND_Q;
+        ptcb->OSTCBStatPend     =  OS_STAT_PEND_OK;
+        if (ptcb->OSTCBStat == OS_STAT_RDY) {
+            OSRdyTbl |= ( 1 << prio );           /* Put task in the ready to run list                  */
+            OS_TASK_RDY_MARK(ptcb);
+        }
+    }
+    OS_EXIT_CRITICAL();
+    OS_Sched();
+}
+
+/*
+*********************************************************************************************************
+*                                       RING A CHANNEL DOORBELL
+*
+* Description: This function is called by OSIPCCommit() to interrupt the peer processor, whose ISR calls
+*              OSIPCNotify() on its end of channel 'id'.  It depends on the part (e.g. a hardware semaphore
+*              release interrupt on dual core STM32) and MUST be implemented by the application.  This
+*              default does nothing: the consumer then has to poll with OSIPCNotify().
+*
+* Arguments  : id            is the channel number given to OSIPCCreate()
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void __attribute__((weak)) OS_IPC_Doorbell (INT8U id)
+{
+    (void)id;                                    /* No doorbell, the consumer polls                    */
+}
+#endif
+
+#if OS_HEAP_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                    MAP A BLOCK SIZE TO A FREE LIST
+*
+* Description: This function returns the first and second level indexes of the free list holding blocks
+*              of 'size' bytes.  This function is INTERNAL to MinOS.
+*
+* Arguments  : size          is the payload size of the block
+*
+*              pfl, psl      are pointers to where the indexes will be deposited
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_HeapMapping (INT32U size, INT8U *pfl, INT8U *psl)
+{
+    INT8U  fl;
+
+    if (size < OS_HEAP_SMALL_BLK) {                        /* Small blocks are linearly split in FL 0  */
+        *pfl = 0;
+        *psl = (INT8U)(size / (OS_HEAP_SMALL_BLK / OS_HEAP_SL_CNT));
+    } else {
+        fl   = (INT8U)(31 - CPU_CntLeadZeros(size));       /* Index of the most significant bit        */
+        *psl = (INT8U)((size >> (fl - OS_HEAP_SL_LOG2)) ^ OS_HEAP_SL_CNT);
+        *pfl = (INT8U)(fl - (OS_HEAP_FL_SHIFT - 1));
+    }
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     INSERT/REMOVE A FREE HEAP BLOCK
+*
+* Description: These functions link a block in, or unlink it from, its segregated free list and keep the
+*              bitmaps up to date.  They are INTERNAL to MinOS.
+*
+* Arguments  : pblk          is a pointer to the block
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_HeapInsert (OS_HEAP_BLK *pblk)
+{
+    INT8U  fl;
+    INT8U  sl;
+
+    OS_HeapMapping(OS_HEAP_SIZE_GET(pblk), &fl, &sl);
+    pblk->OSHeapBlkSize     |= OS_HEAP_BLK_FREE;
+    pblk->OSHeapBlkPrevFree  = (OS_HEAP_BLK *)0;
+    pblk->OSHeapBlkNextFree  = OSHeapFreeTbl[fl][sl];
+    if (pblk->OSHeapBlkNextFree != (OS_HEAP_BLK *)0) {
+        pblk->OSHeapBlkNextFree->OSHeapBlkPrevFree = pblk;
+    }
+    OSHeapFreeTbl[fl][sl]    = pblk;
+    OSHeapSLBitmap[fl]      |= (INT8U)(1u << sl);
+    OSHeapFLBitmap          |= (1u << fl);
+}
+
+static void  OS_HeapRemove (OS_HEAP_BLK *pblk)
+{
+    INT8U  fl;
+    INT8U  sl;
+
+    OS_HeapMapping(OS_HEAP_SIZE_GET(pblk), &fl, &sl);
+    pblk->OSHeapBlkSize &= ~(INT32U)OS_HEAP_BLK_FREE;
+    if (pblk->OSHeapBlkNextFree != (OS_HEAP_BLK *)0) {
+        pblk->OSHeapBlkNextFree->OSHeapBlkPrevFree = pblk->OSHeapBlkPrevFree;
+    }
+    if (pblk->OSHeapBlkPrevFree != (OS_HEAP_BLK *)0) {
+        pblk->OSHeapBlkPrevFree->OSHeapBlkNextFree = pblk->OSHeapBlkNextFree;
+    } else {
+        OSHeapFreeTbl[fl][sl] = pblk->OSHeapBlkNextFree;   /* Block was the head of its list           */
+        if (OSHeapFreeTbl[fl][sl] == (OS_HEAP_BLK *)0) {
+            OSHeapSLBitmap[fl] &= (INT8U)~(1u << sl);
+            if (OSHeapSLBitmap[fl] == 0) {
+                OSHeapFLBitmap &= ~(1u << fl);
+            }
+        }
+    }
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          INITIALIZE THE HEAP
+*
+* Description: This function turns OSHeapMem[] into a single free block followed by an empty, allocated
+*              sentinel block which stops coalescing at the end of the heap.  This function is INTERNAL
+*              to MinOS.
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_HeapInit (void)
+{
+    OS_HEAP_BLK  *pblk;
+    OS_HEAP_BLK  *pend;
+    INT8U         fl;
+    INT8U         sl;
+
+    OSHeapFLBitmap = 0;
+    for (fl = 0; fl < OS_HEAP_FL_CNT; fl++) {
+        OSHeapSLBitmap[fl] = 0;
+        for (sl = 0; sl < OS_HEAP_SL_CNT; sl++) {
+            OSHeapFreeTbl[fl][sl] = (OS_HEAP_BLK *)0;
+        }
+    }
+    OSHeapUsed     = 0;
+    OSHeapUsedPeak = 0;
+
+    pblk                    = (OS_HEAP_BLK *)&OSHeapMem[0];
+    pblk->OSHeapBlkPrevPhys = (OS_HEAP_BLK *)0;
+    pblk->OSHeapBlkSize     = (OS_HEAP_SIZE & ~(INT32U)7u) - 2u * OS_HEAP_HDR;
+    pblk->OSHeapBlkOwner    = OS_HEAP_OWNER_NONE;
+
+    pend                    = OS_HEAP_NEXT_PHYS(pblk);      /* Sentinel: allocated, zero sized         */
+    pend->OSHeapBlkPrevPhys = pblk;
+    pend->OSHeapBlkSize     = 0;
+    pend->OSHeapBlkOwner    = OS_HEAP_OWNER_NONE;
+
+    OS_HeapInsert(pblk);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        ALLOCATE A MEMORY BLOCK
+*
+* Description: This function allocates a block of at least 'size' bytes from the kernel heap and charges
+*              it to the calling task.  The free list searched is rounded up to the next size range so
+*              that its first block always fits: no list is ever walked.
+*
+* Arguments  : size          is the number of bytes needed
+*
+* Returns    : != (void *)0  is a pointer to the allocated block (8 bytes aligned, as malloc())
+*              == (void *)0  if no free block is large enough
+*********************************************************************************************************
+*/
+
+void  *OSHeapAlloc (INT32U size)
+{
+    OS_HEAP_BLK  *pblk;
+    OS_HEAP_BLK  *prem;
+    INT32U        map;
+    INT8U         fl;
+    INT8U         sl;
+
+    if (OSIntNesting > 0) {                                /* See if called from ISR ...               */
+        while(1);
+    }
+    if ((size == 0) || (size >= ((INT32U)1 << (OS_HEAP_FL_CNT + OS_HEAP_FL_SHIFT - 2)))) {
+        return ((void *)0);
+    }
+
+    size = (size + 7u) & ~(INT32U)7u;                      /* Keep payloads 8 bytes aligned (LDRD, VFP)*/
+    if (size < OS_HEAP_MIN_BLK) {
+        size = OS_HEAP_MIN_BLK;
+    }
+    if (size >= OS_HEAP_SMALL_BLK) {                       /* Round up to the next list boundary       */
+        map = size + ((1u << (31 - CPU_CntLeadZeros(size) - OS_HEAP_SL_LOG2)) - 1u);
+    } else {
+        map = size;
+    }
+    OS_HeapMapping(map, &fl, &sl);
+
+    OSSchedLock();
+    map = OSHeapSLBitmap[fl] & (~0u << sl);                /* Suitable list in the same range ?        */
+    if (map == 0) {
+        map = OSHeapFLBitmap & (~0u << (fl + 1));          /* No, any list in a larger range ?         */
+        if (map == 0) {
+            OSSchedUnlock();
+            return ((void *)0);
+        }
+        fl  = (INT8U) CPU_CntTrailZeros(map);
+        map = OSHeapSLBitmap[fl];
+    }
+    sl   = (INT8U) CPU_CntTrailZeros(map);
+    pblk = OSHeapFreeTbl[fl][sl];
+    OS_HeapRemove(pblk);
+
+    if (OS_HEAP_SIZE_GET(pblk) >= size + sizeof(OS_HEAP_BLK)) {  /* Give back the unused tail          */
+        prem                    = (OS_HEAP_BLK *)((INT8U *)pblk + OS_HEAP_HDR + size);
+        prem->OSHeapBlkSize     = OS_HEAP_SIZE_GET(pblk) - size - OS_HEAP_HDR;
+        prem->OSHeapBlkPrevPhys = pblk;
+        prem->OSHeapBlkOwner    = OS_HEAP_OWNER_NONE;
+        OS_HEAP_NEXT_PHYS(prem)->OSHeapBlkPrevPhys = prem;
+        pblk->OSHeapBlkSize     = size;
+        OS_HeapInsert(prem);
+    }
+
+    size        = OS_HEAP_SIZE_GET(pblk) + OS_HEAP_HDR;    /* Charge the block to the calling task     */
+    OSHeapUsed += size;
+    if (OSHeapUsed > OSHeapUsedPeak) {
+        OSHeapUsedPeak = OSHeapUsed;
+    }
+    if (OSTCBCur != (OS_TCB *)0) {
+        pblk->OSHeapBlkOwner     = OSTCBCur->OSTCBPrio;
+        OSTCBCur->OSTCBHeapUsed += size;
+        if (OSTCBCur->OSTCBHeapUsed > OSTCBCur->OSTCBHeapPeak) {
+            OSTCBCur->OSTCBHeapPeak = OSTCBCur->OSTCBHeapUsed;
+        }
+    } else {
+        pblk->OSHeapBlkOwner     = OS_HEAP_OWNER_NONE;
+    }
+    OSSchedUnlock();
+
+    return ((INT8U *)pblk + OS_HEAP_HDR);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          FREE A MEMORY BLOCK
+*
+* Description: This function returns a block to the kernel heap, merges it with its free neighbours and
+*              credits the task which allocated it.
+*
+* Arguments  : pmem          is a pointer to a block returned by OSHeapAlloc().  (void *)0 is ignored.
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSHeapFree (void *pmem)
+{
+    OS_HEAP_BLK  *pblk;
+    OS_HEAP_BLK  *pnext;
+    INT32U        size;
+
+    if (OSIntNesting > 0) {                                /* See if called from ISR ...               */
+        while(1);
+    }
+    if (pmem == (void *)0) {
+        return;
+    }
+
+    pblk = (OS_HEAP_BLK *)((INT8U *)pmem - OS_HEAP_HDR);
+    size = OS_HEAP_SIZE_GET(pblk) + OS_HEAP_HDR;
+
+    OSSchedLock();
+    OSHeapUsed -= size;                                    /* Credit the owner of the block            */
+    if (pblk->OSHeapBlkOwner != OS_HEAP_OWNER_NONE) {
+        OSTCBTbl[pblk->OSHeapBlkOwner].OSTCBHeapUsed -= size;
+    }
+
+    if ((pblk->OSHeapBlkPrevPhys != (OS_HEAP_BLK *)0) &&   /* Merge with the previous block if free    */
+        ((pblk->OSHeapBlkPrevPhys->OSHeapBlkSize & OS_HEAP_BLK_FREE) != 0)) {
+        OS_HeapRemove(pblk->OSHeapBlkPrevPhys);
+        pblk->OSHeapBlkPrevPhys->OSHeapBlkSize += OS_HEAP_SIZE_GET(pblk) + OS_HEAP_HDR;
+        pblk = pblk->OSHeapBlkPrevPhys;
+    }
+    pnext = OS_HEAP_NEXT_PHYS(pblk);
+    if ((pnext->OSHeapBlkSize & OS_HEAP_BLK_FREE) != 0) {  /* Merge with the next block if free        */
+        OS_HeapRemove(pnext);
+        pblk->OSHeapBlkSize += OS_HEAP_SIZE_GET(pnext) + OS_HEAP_HDR;
+    }
+    OS_HEAP_NEXT_PHYS(pblk)->OSHeapBlkPrevPhys = pblk;
+    pblk->OSHeapBlkOwner = OS_HEAP_OWNER_NONE;
+    OS_HeapInsert(pblk);
+    OSSchedUnlock();
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                         QUERY THE HEAP STATE
+*
+* Description: This function reports the heap usage and fragmentation.  It walks every block of the heap
+*              and is meant for diagnostics, not for time critical code.
+*
+* Arguments  : pdata         is a pointer to where the heap state will be deposited
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSHeapQuery (OS_HEAP_DATA *pdata)
+{
+    OS_HEAP_BLK  *pblk;
+    INT32U        size;
+    INT32U        ratio;
+
+    pdata->OSHeapSize    = OS_HEAP_SIZE;
+    pdata->OSHeapFree    = 0;
+    pdata->OSHeapMaxFree = 0;
+    pdata->OSHeapNFree   = 0;
+
+    OSSchedLock();
+    pdata->OSHeapUsed     = OSHeapUsed;
+    pdata->OSHeapUsedPeak = OSHeapUsedPeak;
+    pblk = (OS_HEAP_BLK *)&OSHeapMem[0];
+    while (OS_HEAP_SIZE_GET(pblk) != 0) {                  /* Stop at the sentinel                     */
+        if ((pblk->OSHeapBlkSize & OS_HEAP_BLK_FREE) != 0) {
+            size = OS_HEAP_SIZE_GET(pblk);
+            pdata->OSHeapFree += size;
+            pdata->OSHeapNFree++;
+            if (size > pdata->OSHeapMaxFree) {
+                pdata->OSHeapMaxFree = size;
+            }
+        }
+        pblk = OS_HEAP_NEXT_PHYS(pblk);
+    }
+    OSSchedUnlock();
+
+    if (pdata->OSHeapFree == 0) {                          /* Free space in the largest block (1/1000) */
+        ratio = 1000u;
+    } else if (pdata->OSHeapFree < 0x400000u) {            /* No overflow of MaxFree * 1000            */
+        ratio = (pdata->OSHeapMaxFree * 1000u) / pdata->OSHeapFree;
+    } else {
+        ratio = pdata->OSHeapMaxFree / (pdata->OSHeapFree / 1000u);
+    }
+    if (ratio > 1000u) {
+        ratio = 1000u;
+    }
+    pdata->OSHeapFrag = (INT16U)(1000u - ratio);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     QUERY THE HEAP USAGE OF A TASK
+*
+* Description: This function reports the heap bytes charged to a task.
+*
+* Arguments  : prio          is the priority of the task
+*
+*              ppeak         is a pointer to where the highest usage of the task will be deposited.  It
+*                            may be (INT32U *)0.
+*
+* Returns    : The number of bytes currently charged to the task, block headers included.  0 if 'prio'
+*              is not a valid priority.
+*********************************************************************************************************
+*/
+
+INT32U  OSHeapTaskUsed (INT8U prio, INT32U *ppeak)
+{
+    if (prio > OS_TASK_IDLE_PRIO) {
+        if (ppeak != (INT32U *)0) {
+            *ppeak = 0;
+        }
+        return (0);
+    }
+    if (ppeak != (INT32U *)0) {
+        *ppeak = OSTCBTbl[prio].OSTCBHeapPeak;
+    }
+    return (OSTCBTbl[prio].OSTCBHeapUsed);
+}
+#endif
+
+#if OS_STREAM_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        CREATE A STREAM BUFFER
+*
+* Description: This function creates a stream buffer if free stream control blocks are available.
+*
+* Arguments  : buf           is a pointer to the storage area of the stream.
+*
+*              size          is the size of the storage area in bytes.
+*
+*              trig          is the trigger level: a reader blocked on an empty stream is woken up once
+*                            at least 'trig' bytes were written (1 ... size).
+*
+* Returns    : A pointer to the stream control block.  The function CANNOT return normally if no
+*              control block is available.
+*********************************************************************************************************
+*/
+
+OS_STREAM  *OSStreamCreate (INT8U *buf, INT16U size, INT16U trig)
+{
+    OS_STREAM  *pstream;
+    OS_CPU_SR   cpu_sr = 0;
+
+    if (trig == 0) {                                   /* Clamp the trigger level to the buffer size  */
+        trig = 1;
+    }
+    if (trig > size) {
+        trig = size;
+    }
+
+    OS_ENTER_CRITICAL();
+    if (OSStreamFreeList != (OS_STREAM *)0) {
+        pstream          = OSStreamFreeList;           /* Get next free stream control block          */
+        OSStreamFreeList = OSStreamFreeList->OSStreamNext;
+    }
+    else
+    {
+        while(1);//No enough free stream control block
     }
-    
-    pevent->OSQStart           = start;               /*      Initialize the queue                 */
-    pevent->OSQEnd             = &start[size];
-    pevent->OSQIn              = start;
-    pevent->OSQOut             = start;
-    pevent->OSQSize            = size;
-    pevent->OSNMsgs            = 0;
 
-    pevent->OSEventWaitTbl     = 0; /* No task waiting on event                           */
+    pstream->OSStreamBuf       = buf;                  /*      Initialize the stream                  */
+    pstream->OSStreamSize      = size;
+    pstream->OSStreamIn        = 0;
+    pstream->OSStreamOut       = 0;
+    pstream->OSStreamNBytes    = 0;
+    pstream->OSStreamTrigLevel = trig;
+    pstream->OSStreamWaitTbl   = 0;                    /* No task waiting on stream                   */
+    pstream->OSStreamNext      = (OS_STREAM *)0;
+    OS_EXIT_CRITICAL();
+
+    return (pstream);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     WRITE BYTES TO A STREAM BUFFER
+*
+* Description: This function copies bytes into a stream buffer in at most two contiguous spans.  It never
+*              blocks and may be called from an ISR.
+*
+* Arguments  : pstream       is a pointer to the stream buffer
+*
+*              pdata         is a pointer to the bytes to write
+*
+*              len           is the number of bytes to write
+*
+* Returns    : The number of bytes written, less than 'len' if the stream buffer is full.
+*********************************************************************************************************
+*/
+
+INT16U  OSStreamWrite (OS_STREAM *pstream, const void *pdata, INT16U len)
+{
+    INT16U     in;
+    INT16U     nfree;
+    INT16U     span;
+    OS_CPU_SR  cpu_sr = 0;
 
+    OS_ENTER_CRITICAL();
+    in    = pstream->OSStreamIn;                       /* Only the writer moves OSStreamIn            */
+    nfree = pstream->OSStreamSize - pstream->OSStreamNBytes;
     OS_EXIT_CRITICAL();
 
-    return (pevent);
+    if (len > nfree) {
+        len = nfree;
+    }
+    if (len == 0) {
+        return (0);
+    }
+
+    span = pstream->OSStreamSize - in;                 /* Bytes up to the end of the storage area     */
+    if (span > len) {
+        span = len;
+    }
+    memcpy(&pstream->OSStreamBuf[in], pdata, span);
+    memcpy(&pstream->OSStreamBuf[0], (const INT8U *)pdata + span, len - span);
+
+    OSStreamWriteCommit(pstream, len);
+    return (len);
 }
 
 /*$PAGE*/
 /*
 *********************************************************************************************************
-*                                     PEND ON A QUEUE FOR A MESSAGE
+*                                CLAIM A CONTIGUOUS REGION OF A STREAM BUFFER
 *
-* Description: This function waits for a message to be sent to a queue
+* Description: This function returns the largest contiguous free region of a stream buffer so that the
+*              writer (typically a DMA) can fill it in place.  The data becomes visible to the reader
+*              once OSStreamWriteCommit() is called.
 *
-* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+* Arguments  : pstream       is a pointer to the stream buffer
 *
-*              timeout       is an optional timeout period (in clock ticks).  If non-zero, your task will
-*                            wait for a message to arrive at the queue up to the amount of time
-*                            specified by this argument.  If you specify 0, however, your task will wait
-*                            forever at the specified queue or, until a message arrives.
+*              plen          is a pointer to where the size of the region (bytes) will be deposited.  It
+*                            is 0 if the stream buffer is full.
+*
+* Returns    : A pointer to the start of the free region.
+*********************************************************************************************************
+*/
+
+INT8U  *OSStreamWriteClaim (OS_STREAM *pstream, INT16U *plen)
+{
+    INT16U     in;
+    INT16U     nfree;
+    OS_CPU_SR  cpu_sr = 0;
+
+    OS_ENTER_CRITICAL();
+    in    = pstream->OSStreamIn;
+    nfree = pstream->OSStreamSize - pstream->OSStreamNBytes;
+    OS_EXIT_CRITICAL();
+
+    if (nfree > pstream->OSStreamSize - in) {          /* Stop at the end of the storage area         */
+        nfree = pstream->OSStreamSize - in;
+    }
+    *plen = nfree;
+    return (&pstream->OSStreamBuf[in]);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                  COMMIT BYTES WRITTEN TO A STREAM BUFFER
+*
+* Description: This function publishes 'len' bytes written in place after OSStreamWriteClaim() and wakes
+*              up the reader if the trigger level is reached.  It may be called from an ISR.
+*
+* Arguments  : pstream       is a pointer to the stream buffer
+*
+*              len           is the number of bytes written, at most the size of the claimed region
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSStreamWriteCommit (OS_STREAM *pstream, INT16U len)
+{
+    OS_TCB    *ptcb;
+    INT8U      prio;
+    OS_CPU_SR  cpu_sr = 0;
+
+    OS_ENTER_CRITICAL();
+    pstream->OSStreamIn += len;
+    if (pstream->OSStreamIn >= pstream->OSStreamSize) {    /* Wrap IN index at end of the storage area */
+        pstream->OSStreamIn -= pstream->OSStreamSize;
+    }
+    pstream->OSStreamNBytes += len;
+
+    if ((pstream->OSStreamWaitTbl != 0) &&                 /* Wake up the reader on trigger level      */
+        (pstream->OSStreamNBytes >= pstream->OSStreamTrigLevel)) {
+        prio                  = (INT8U) CPU_CntTrailZeros( pstream->OSStreamWaitTbl );
+        ptcb                  =  &OSTCBTbl[prio];
+        ptcb->OSTCBDly        =  0;                        /* Prevent OSTimeTick() from readying task  */
+        ptcb->OSTCBStat      &= ~OS_STAT_PEND_STREAM;
+        ptcb->OSTCBStatPend   =  OS_STAT_PEND_OK;
+        if (ptcb->OSTCBStat == OS_STAT_RDY) {
+            OSRdyTbl |= ( 1 << prio );                     /* Put task in the ready to run list        */
+            OS_TASK_RDY_MARK(ptcb);
+        }
+        pstream->OSStreamWaitTbl &= ~( 1 << prio );        /* Remove task from wait list               */
+
+        OS_EXIT_CRITICAL();
+        OS_Sched();
+        return;
+    }
+    OS_EXIT_CRITICAL();
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                    READ BYTES FROM A STREAM BUFFER
+*
+* Description: This function reads up to 'len' bytes from a stream buffer.  If the stream buffer is empty
+*              the task waits until the trigger level is reached or the timeout expires.
+*
+* Arguments  : pstream       is a pointer to the stream buffer
+*
+*              pdata         is a pointer to where the bytes will be copied
+*
+*              len           is the maximum number of bytes to read
+*
+*              timeout       is an optional timeout period (in clock ticks).  If you specify 0, your task
+*                            will wait forever until the trigger level is reached.
 *
 *              perr          is a pointer to where an error message will be deposited.  Possible error
 *                            messages are:
 *
-*                            OS_ERR_NONE         The call was successful and your task received a
-*                                                message.
-*                            OS_ERR_TIMEOUT      A message was not received within the specified 'timeout'.
+*                            OS_ERR_NONE         Bytes were read.
+*                            OS_ERR_TIMEOUT      The trigger level was not reached within 'timeout', the
+*                                                bytes available (if any) were read.
 *
+* Returns    : The number of bytes read.
 *********************************************************************************************************
 */
 
-void  *OSQPend (OS_EVENT *pevent, INT16U timeout, INT8U *perr)
+INT16U  OSStreamRead (OS_STREAM *pstream, void *pdata, INT16U len, INT16U timeout, INT8U *perr)
 {
-    void      *pmsg;
+    return (OS_StreamRead(pstream, pdata, len, timeout, 0, perr));
+}
+
+#if OS_HRT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                             READ BYTES FROM A STREAM BUFFER (MICROSECOND TIMEOUT)
+*
+* Description: This function is identical to OSStreamRead() but the timeout is given in microseconds (at
+*              most OS_HRT_US_MAX, 0 means wait forever) and is timed by the high resolution timer.
+*********************************************************************************************************
+*/
+
+INT16U  OSStreamReadUs (OS_STREAM *pstream, void *pdata, INT16U len, INT32U us, INT8U *perr)
+{
+    return (OS_StreamRead(pstream, pdata, len, 0, us, perr));
+}
+#endif
+
+/*
+*********************************************************************************************************
+*                                    READ BYTES FROM A STREAM BUFFER
+*
+* Description: This function is INTERNAL to MinOS and is used by OSStreamRead() and OSStreamReadUs().
+*              The timeout is given either in ticks ('timeout') or in microseconds ('us').
+*********************************************************************************************************
+*/
 
+static INT16U  OS_StreamRead (OS_STREAM *pstream, void *pdata, INT16U len, INT16U timeout, INT32U us,
+                              INT8U *perr)
+{
+    INT16U     out;
+    INT16U     span;
     OS_CPU_SR  cpu_sr = 0;
 
+#if OS_HRT_EN == 0
+    (void)us;
+#endif
     if (OSIntNesting > 0) {                      /* See if called from ISR ...                         */
         while(1);
     }
-		
+
+    *perr = OS_ERR_NONE;
     OS_ENTER_CRITICAL();
-    
-    //消息队列中有现成的，直接返回结果，即若队列中有多个消息，该任务会一口气执行完所有消息再挂起
-    if (pevent->OSNMsgs > 0) {                    /* See if any messages in the queue                   */
-        
-        //正常出列
-        //取出队列中地址数值，并将指针下移一个单位，将已有数量减一
-        pmsg = *pevent->OSQOut++;                    /* Yes, extract oldest message from the queue         */
-        pevent->OSNMsgs--;                        /* Update the number of entries in the queue          */
-        if (pevent->OSQOut == pevent->OSQEnd) {          /* Wrap OUT pointer if we are at the end of the queue */
-            pevent->OSQOut = pevent->OSQStart;
+    if (pstream->OSStreamNBytes == 0) {          /* Nothing to read, wait for the trigger level        */
+        OS_TASK_BLOCK_CHK();
+        OSTCBCur->OSTCBStat     |= OS_STAT_PEND_STREAM;
+        OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK;
+        OSTCBCur->OSTCBDly       = timeout;
+        pstream->OSStreamWaitTbl |=  ( 1<< OSTCBCur->OSTCBPrio );
+        OSRdyTbl                 &= ~( 1<< OSTCBCur->OSTCBPrio );
+#if OS_HRT_EN > 0
+        if (us > 0) {                            /* Load the high resolution timeout                   */
+            OS_HRTInsert(OSTCBCur, OS_HRTDeadline(us));
         }
+#endif
         OS_EXIT_CRITICAL();
-        *perr = OS_ERR_NONE;
-        return (pmsg);                           /* Return message received                            */
+        OS_Sched();
+        OS_ENTER_CRITICAL();
+#if OS_HRT_EN > 0
+        OS_HRTRemove(OSTCBCur);                  /* Still linked if the trigger level was reached      */
+#endif
+
+        if (OSTCBCur->OSTCBStatPend != OS_STAT_PEND_OK) {
+            pstream->OSStreamWaitTbl &= ~( 1 << OSTCBCur->OSTCBPrio );
+            *perr = OS_ERR_TIMEOUT;
+        }
+        OSTCBCur->OSTCBStat      = OS_STAT_RDY;
+        OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK;
+    }
+    out = pstream->OSStreamOut;                  /* Only the reader moves OSStreamOut                  */
+    if (len > pstream->OSStreamNBytes) {
+        len = pstream->OSStreamNBytes;
     }
-    OSTCBCur->OSTCBStat     |= OS_STAT_PEND_Q;  //任务状态：正在等Q /* Task will have to pend for a message to be posted  */
-    OSTCBCur->OSTCBStatPend  = OS_STAT_PEND_OK; //等待状态：正常等待
-    OSTCBCur->OSTCBDly       = timeout;          /* Load timeout into TCB                              */
-    
-    //内部设置等待该事件的任务有哪些？有本任务！
-    // OS_EventTaskWait(pevent);                    /* Suspend task until event or timeout occurs         */
-    
-    OSTCBCur->OSTCBEventPtr      = pevent;                 /* Store ptr to ECB in TCB         */
-    pevent->OSEventWaitTbl          |=  ( 1<< OSTCBCur->OSTCBPrio );/* Put task in waiting list        */
-    OSRdyTbl                    &= ~( 1<< OSTCBCur->OSTCBPrio );/* Task no longer ready                              */
-    
-    
     OS_EXIT_CRITICAL();
-    OS_Sched(); 
-    
-    /////////////////////////////////////////////////////////////
-    /////////////////////////////////////////////////////////////
-    //已跳出该任务。。。直至超时时间到或收到Q将返回继续执行
-                                     /* Find next highest priority task ready to run       */
-    OS_ENTER_CRITICAL();
-
-    //查看到底是超时还是确实收到Q了？
-    switch (OSTCBCur->OSTCBStatPend) {                /* See if we timed-out or aborted                */
-        //确实收到Q 了！
-        case OS_STAT_PEND_OK:                         /* Extract message from TCB (Put there by QPost) */
-             pmsg =  OSTCBCur->OSTCBMsg;
-            *perr =  OS_ERR_NONE;
-             break;
 
-        //未收到Q，Pend超时了！
-        case OS_STAT_PEND_TO:
-        default:
-            //  OS_EventTaskRemove(OSTCBCur, pevent);
-             pevent->OSEventWaitTbl &= ~( 1 << OSTCBCur->OSTCBPrio ); /* Remove task from wait list                  */
-             pmsg = (void *)0;
-            *perr =  OS_ERR_TIMEOUT;                  /* Indicate that we didn't get event within TO   */
-             break;
+    span = pstream->OSStreamSize - out;          /* Bytes up to the end of the storage area            */
+    if (span > len) {
+        span = len;
     }
+    memcpy(pdata, &pstream->OSStreamBuf[out], span);
+    memcpy((INT8U *)pdata + span, &pstream->OSStreamBuf[0], len - span);
 
-    //任务已就绪
-    OSTCBCur->OSTCBStat          =  OS_STAT_RDY;      /* Set   task  status to ready                   */
-    
-    //该次pend标志清除，下次pend重新设置
-    OSTCBCur->OSTCBStatPend      =  OS_STAT_PEND_OK;  /* Clear pend  status                            */
-    OSTCBCur->OSTCBEventPtr      = (OS_EVENT  *)0;    /* Clear event pointers                          */
-
-    //清除已收到的Msg，即已将消息地址扔出去（赋值给内部变量pmsg），该Event表中已无记录	
-    OSTCBCur->OSTCBMsg           = (void      *)0;    /* Clear  received message                       */
+    OS_ENTER_CRITICAL();
+    pstream->OSStreamOut += len;
+    if (pstream->OSStreamOut >= pstream->OSStreamSize) {   /* Wrap OUT index at end of the storage area*/
+        pstream->OSStreamOut -= pstream->OSStreamSize;
+    }
+    pstream->OSStreamNBytes -= len;
     OS_EXIT_CRITICAL();
-    return (pmsg);                                    /* Return received message                       */
+    return (len);
 }
+#endif
 
-
+#if OS_WORK_EN > 0
 /*$PAGE*/
 /*
 *********************************************************************************************************
-*                                        POST MESSAGE TO A QUEUE
+*                                        INITIALIZE A WORK ITEM
 *
-* Description: This function sends a message to a queue
+* Description: This function sets the job carried by a work item.  It MUST be called before the item is
+*              posted for the first time and not while it is pending.
 *
-* Arguments  : pevent        is a pointer to the event control block associated with the desired queue
+* Arguments  : pwork         is a pointer to the work item
 *
-*              pmsg          is a pointer to the message to send.
+*              fnct          is the function the worker task will call
 *
-* Returns    : OS_ERR_NONE           The call was successful and the message was sent
-*              OS_ERR_Q_FULL         If the queue cannot accept any more messages because it is full.
+*              parg          is the argument passed to 'fnct'
 *
+* Returns    : none
 *********************************************************************************************************
 */
 
-INT8U  OSQPost (OS_EVENT *pevent, void *pmsg)
+void  OSWorkInit (OS_WORK *pwork, void (*fnct)(void *parg), void *parg)
 {
-    OS_TCB  *ptcb;
-    INT8U    prio;
-    OS_CPU_SR  cpu_sr = 0;
-
-    OS_ENTER_CRITICAL();
+    pwork->OSWorkFnct    = fnct;
+    pwork->OSWorkArg     = parg;
+    pwork->OSWorkPending = 0;
+}
 
-    //有任务正在等待该Q！
-    //若中断中连续Post会出现覆盖？不会入列？YES!
-    if (pevent->OSEventWaitTbl != 0) {                     /* See if any task pending on queue             */
-                                                       /* Ready highest priority task waiting on event */
-        //该次Post只会喂饱一个任务（即等待该事件的任务中优先级最高的那个）
-        // OS_EventTaskRdy(pevent, pmsg);
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                       POST A JOB TO A WORK QUEUE
+*
+* Description: This function hands a job over to the worker task(s) of a work queue.  It may be called
+*              from an ISR.  Posting a job which has not run yet is coalesced with the pending one.
+*              A job can be posted again as soon as it has started: with several workers on the same
+*              queue, it may then run on two workers at once, so such jobs MUST be reentrant.
+*
+* Arguments  : pevent        is a pointer to the work queue (OSWorkQ or a queue created by OSQCreate())
+*
+*              pwork         is a pointer to the work item to run
+*
+* Returns    : OS_ERR_NONE           The job was queued
+*              OS_ERR_WORK_PENDING   The job was already pending and will run only once
+*********************************************************************************************************
+*/
 
-                                                        /* Find HPT waiting for message                */
-        prio                  = (INT8U) CPU_CntTrailZeros( pevent-> OSEventWaitTbl );
+INT8U  OSWorkPost (OS_EVENT *pevent, OS_WORK *pwork)
+{
+    OS_CPU_SR  cpu_sr = 0;
 
-        ptcb                  =  &OSTCBTbl[prio];        /* Point to this task's OS_TCB                 */
-        ptcb->OSTCBDly        =  0;                         /* Prevent OSTimeTick() from readying task     */
-            
-        ptcb->OSTCBMsg        =  pmsg;                      /* Send message directly to waiting task       */
-            
-        ptcb->OSTCBStat      &= ~OS_STAT_PEND_Q;//若该任务只是在等待Q，则此语句相当于将任务就绪了                       /* Clear bit associated with event type        */
-        ptcb->OSTCBStatPend   =  OS_STAT_PEND_OK;                 /* Set pend status of post or abort            */
-                                                            /* See if task is ready (could be susp'd)      */
-        if (ptcb->OSTCBStat == OS_STAT_RDY) {
-            OSRdyTbl |= ( 1 << ptcb->OSTCBPrio );           /* Put task in the ready to run list           */
-        }
+    OS_ENTER_CRITICAL();
+    if (pwork->OSWorkPending != 0) {                        /* Job not run yet, nothing more to do      */
+        OS_EXIT_CRITICAL();
+        return (OS_ERR_WORK_PENDING);
+    }
+    pwork->OSWorkPending = 1;
+    OS_EXIT_CRITICAL();
 
-        // OS_EventTaskRemove(ptcb, pevent);                   /* Remove this task from event   wait list     */
-        pevent->OSEventWaitTbl &= ~( 1 << ptcb->OSTCBPrio ); /* Remove task from wait list                  */
+    return (OSQPost(pevent, pwork));
+}
 
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          RUN A WORK QUEUE
+*
+* Description: This function is the body of a worker task.  It runs the jobs of a work queue in the
+*              order they were posted.  OSQPend() returns at once while jobs are queued, so a whole batch
+*              is drained without any context switch.  Several tasks may run the same queue, the highest
+*              priority idle worker takes the next job.
+*
+*                           void MyWorker (void)
+*                           {
+*                               OSWorkRun(MyWorkQ);
+*                           }
+*
+* Arguments  : pevent        is a pointer to the work queue
+*
+* Returns    : This function never returns
+*********************************************************************************************************
+*/
 
-        OS_EXIT_CRITICAL();
-        OS_Sched();//若在中断中Post该调度将无效，将在中断退出时（OSIntExit）执行有效调度，前提是无中断嵌套                                    /* Find highest priority task ready to run      */
-        return (OS_ERR_NONE);
-    }
-    
-    if (pevent->OSNMsgs >= pevent->OSQSize) {               /* Make sure queue is not full                  */
-        OS_EXIT_CRITICAL();
-        while(1);//  OS_ERR_Q_FULL 消息队列已满，需增大数组
-    }
+void  OSWorkRun (OS_EVENT *pevent)
+{
+    OS_WORK   *pwork;
+    INT8U      err;
 
-    //正常入列
-    *pevent->OSQIn++ = pmsg;                               /* Insert message into queue                    */
-    pevent->OSNMsgs++;                                  /* Update the nbr of entries in the queue       */
-    if (pevent->OSQIn == pevent->OSQEnd) {                     /* Wrap IN ptr if we are at end of queue        */
-        pevent->OSQIn = pevent->OSQStart;
+    for (;;) {
+        pwork = (OS_WORK *)OSQPend(pevent, 0, &err);
+        pwork->OSWorkPending = 0;                           /* Job can be posted again while it runs    */
+        pwork->OSWorkFnct(pwork->OSWorkArg);
     }
-    OS_EXIT_CRITICAL();
-    return (OS_ERR_NONE);
 }
-
 #endif
 
 /********************* (C) COPYRIGHT 2015 Windy Albert **************************** END OF FILE ********/
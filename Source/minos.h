@@ -42,8 +42,48 @@
 *  OS_TASK_IDLE_STK_SIZE    : Idle task stack size (# of OS_STK wide entries)    
 *  OS_Q_EN                  : Enable (1) or Disable (0) code generation for QUEUES
 *  OS_MAX_QS                : Max.number of queue control blocks in your application
+*  OS_PREEMPT_THRESH_EN     : Enable (1) or Disable (0) per-task preemption thresholds.  A running task
+*                             can only be preempted by tasks whose priority is higher than its threshold
+*  OS_WORK_EN               : Enable (1) or Disable (0) the deferred-work queue (requires OS_Q_EN)
+*  OS_TASK_WORK_PRIO        : Priority of the kernel worker task which runs jobs posted to OSWorkQ.  Just
+*                             above the idle task by default, so that jobs never delay application tasks
+*  OS_TASK_WORK_STK_SIZE    : Worker task stack size (# of OS_STK wide entries)
+*  OS_WORK_Q_SIZE           : Max.number of jobs pending in OSWorkQ.  OSWorkQ also uses one of OS_MAX_QS
+*  OS_STREAM_EN             : Enable (1) or Disable (0) code generation for STREAM BUFFERS
+*  OS_MAX_STREAMS           : Max.number of stream buffers in your application
+*  OS_SCHED_LOCK_EN         : Enable (1) or Disable (0) code generation for OSSchedLock()/OSSchedUnlock()
+*  OS_HEAP_EN               : Enable (1) or Disable (0) the kernel heap (requires OS_SCHED_LOCK_EN)
+*  OS_HEAP_SIZE             : Size of the kernel heap in bytes (multiple of 8, less than 16 MB)
+*  OS_STAT_EN               : Enable (1) or Disable (0) queue statistics and the ECB/TCB iterators
+*  OS_Q_PRIO_EN             : Enable (1) or Disable (0) priority message queues (see OSQPrioCreate())
+*  OS_Q_PRIO_LVLS           : Number of message priority levels of a priority queue ( 1 - 32 )
+*  OS_Q_TRACE_EN            : Enable (1) or Disable (0) message latency tracing through queues (OSQTraceStart())
+*  OS_HRT_EN                : Enable (1) or Disable (0) microsecond timeouts (OSTimeDlyUs() and the ...Us() pend calls)
+*  OS_HRT_TICKS_PER_US      : Number of high resolution timer counts per microsecond
+*  OS_LAT_EN                : Enable (1) or Disable (0) the wake-to-run latency histograms (OSTaskLatGet())
+*  OS_IPC_EN                : Enable (1) or Disable (0) inter-processor channels in shared memory (requires OS_Q_EN)
+*  OS_IPC_SLOTS             : Number of messages of an inter-processor channel ( power of 2 )
+*  OS_TASK_BASIC_EN         : Enable (1) or Disable (0) basic tasks, run-to-completion tasks sharing one stack
+*  OS_TASK_BASIC_STK_SIZE   : Shared stack size of the basic tasks (# of OS_STK wide entries)
+*  OS_AO_EN                 : Enable (1) or Disable (0) the active object framework (minos_ao.c, requires OS_Q_EN)
+*  OS_AO_MAX_SIGS           : Number of signals which can be published ( signals 0 ~ [OS_AO_MAX_SIGS-1] )
+*  OS_AO_MAX_POOLS          : Max.number of event pools
+*  OS_STATIC_CFG_EN         : Enable (1) or Disable (0) the static tasks and queues listed below.  OSInit()
+*                             builds them from const tables, priorities and sizes are checked when compiling
+*  OS_STATIC_TASK_TBL       : List of static tasks TASK(name, prio, stack size), e.g.
+*                                 #define OS_STATIC_TASK_TBL(TASK)  TASK(Task00, 1, 128) \
+*                                                                   TASK(Task01, 2, 256)
+*                             The stack name##_Stk is allocated by MinOS, 'name' is 'void name(void)'
+*  OS_STATIC_Q_TBL          : List of static queues Q(name, size), e.g.
+*                                 #define OS_STATIC_Q_TBL(Q)        Q(Event_Q, 8)
+*                             The queue is then referenced as OS_Q(Event_Q)
 *  OS_SysTick_Handler       : The SysTick handler function for MinOS
 *  OS_PendSV_Handler        : The PendSV handler function for MinOS
+*  OS_HRT_Handler           : The compare interrupt handler of the high resolution timer
+*
+*  OS_HOST_SIM              : Not set here, defined on the command line by the host test builds (Test/).
+*                             The __asm port functions are left out, the host port supplies them, and
+*                             "os_host_cfg.h" can override the configuration below
 *********************************************************************************************************
 */
 
@@ -51,9 +91,47 @@
 #define OS_TASK_IDLE_STK_SIZE                   128  
 #define OS_Q_EN                                   1
 #define OS_MAX_QS                                 4
+#define OS_PREEMPT_THRESH_EN                      0
+#define OS_WORK_EN                                0
+#define OS_TASK_WORK_PRIO        (OS_TASK_IDLE_PRIO - 1)
+#define OS_TASK_WORK_STK_SIZE                   128
+#define OS_WORK_Q_SIZE                            8
+#define OS_STREAM_EN                              0
+#define OS_MAX_STREAMS                            2
+#define OS_SCHED_LOCK_EN                          0
+#define OS_HEAP_EN                                0
+#define OS_HEAP_SIZE                           4096
+#define OS_STAT_EN                                0
+#define OS_Q_PRIO_EN                              0
+#define OS_Q_PRIO_LVLS                            8
+#define OS_Q_TRACE_EN                             0
+#define OS_HRT_EN                                 0
+#define OS_HRT_TICKS_PER_US                       1
+#define OS_LAT_EN                                 0
+#define OS_IPC_EN                                 0
+#define OS_IPC_SLOTS                             64
+#define OS_TASK_BASIC_EN                          0
+#define OS_TASK_BASIC_STK_SIZE                  256
+#define OS_AO_EN                                  0
+#define OS_AO_MAX_SIGS                           32
+#define OS_AO_MAX_POOLS                           3
+#define OS_STATIC_CFG_EN                          0
+#define OS_STATIC_TASK_TBL(TASK)
+#define OS_STATIC_Q_TBL(Q)
 
 #define OS_SysTick_Handler          SysTick_Handler
 #define OS_PendSV_Handler            PendSV_Handler
+#define OS_HRT_Handler               TIM2_IRQHandler
+
+#ifdef  OS_HOST_SIM
+#include "os_host_cfg.h"                        /* Configuration of the host test build               */
+#endif
+
+                                                 /* Tasks can pend on kernel objects                   */
+#define OS_EVENT_EN                 ((OS_Q_EN > 0) || (OS_STREAM_EN > 0))
+                                                 /* Queues record their type in OSEventType            */
+#define OS_EVENT_TYPE_EN            ((OS_STAT_EN > 0) || (OS_Q_PRIO_EN > 0) || (OS_Q_TRACE_EN > 0) || \
+                                     (OS_IPC_EN > 0))
 
 /*
 *********************************************************************************************************
@@ -65,6 +143,8 @@
 typedef unsigned char  INT8U;                    /* Unsigned  8 bit quantity                           */
 typedef unsigned short INT16U;                   /* Unsigned 16 bit quantity                           */
 typedef unsigned int   INT32U;                   /* Unsigned 32 bit quantity                           */
+typedef signed   int   INT32S;                   /* Signed   32 bit quantity                           */
+typedef unsigned long long INT64U;               /* Unsigned 64 bit quantity                           */
 
 typedef unsigned int   OS_STK;                   /* Each stack entry is 32-bit wide                    */
 typedef unsigned int   OS_CPU_SR;                /* Define size of CPU status register (PSR = 32 bits) */
@@ -82,6 +162,20 @@ typedef unsigned int   OS_CPU_SR;                /* Define size of CPU status re
 #define  OS_EXT  extern
 #endif
 
+/*
+*********************************************************************************************************
+*                                           CPU SPECIFIC MACROS
+*
+*  OS_ENTER_CRITICAL() and OS_EXIT_CRITICAL() save the interrupt state in a local 'OS_CPU_SR cpu_sr'
+*  variable of the caller, so critical sections can be nested.
+*********************************************************************************************************
+*/
+
+#define  OS_ENTER_CRITICAL()          {cpu_sr = __get_PRIMASK();__disable_irq();}//不管当前中断使能如何，我要关中断了
+#define  OS_EXIT_CRITICAL()           {__set_PRIMASK(cpu_sr);}                   //将中断状态恢复到我关之前
+#define  CPU_CntTrailZeros(data)       __CLZ(__RBIT(data))
+#define  CPU_CntLeadZeros(data)        __CLZ(data)
+
 /*$PAGE*/
 /*
 *********************************************************************************************************
@@ -90,12 +184,30 @@ typedef unsigned int   OS_CPU_SR;                /* Define size of CPU status re
 */
 #define  OS_STAT_RDY               0x00u    /* Ready to run                                            */
 #define  OS_STAT_PEND_Q            0x04u    /* Pending on queue                                        */
+#define  OS_STAT_PEND_STREAM       0x40u    /* Pending on stream buffer                                */
+#define  OS_STAT_PEND_ANY         (OS_STAT_PEND_Q | OS_STAT_PEND_STREAM)
 
 #define  OS_STAT_PEND_OK              0u    /* Pending status OK, 1-not pending, or 2-pending complete     */
 #define  OS_STAT_PEND_TO              1u    /* Pending timed out                                       */
 
 #define  OS_ERR_NONE                  0u
 #define  OS_ERR_TIMEOUT              10u
+#define  OS_ERR_Q_FULL               30u
+#define  OS_ERR_WORK_PENDING        130u
+
+#define  OS_EVENT_TYPE_UNUSED         0u
+#define  OS_EVENT_TYPE_Q              1u
+#define  OS_EVENT_TYPE_Q_PRIO         2u
+#define  OS_EVENT_TYPE_IPC_TX         3u    /* Producer end of an inter-processor channel             */
+#define  OS_EVENT_TYPE_IPC_RX         4u    /* Consumer end of an inter-processor channel             */
+
+#define  OS_POST_OPT_NONE          0x00u    /* Post to the end of the queue                            */
+#define  OS_POST_OPT_FRONT         0x01u    /* Post to the front of the queue (LIFO)                   */
+#define  OS_POST_OPT_BROADCAST     0x02u    /* Post to ALL tasks waiting on the queue                  */
+
+#define  OS_Q_PRIO_LOWEST         (OS_Q_PRIO_LVLS - 1u)     /* Message priority used by OSQPost()     */
+
+#define  OS_PRIO_NONE              0xFFu    /* No task / end of iteration                              */
 
 /*$PAGE*/
 /*
@@ -105,6 +217,30 @@ typedef unsigned int   OS_CPU_SR;                /* Define size of CPU status re
 */
 
 #if OS_Q_EN > 0
+#if OS_Q_TRACE_EN > 0
+typedef struct os_q_ts {
+    INT32U            OSQTsEnq;         /* OS_TS_GET() when the message was posted                 */
+    INT32U            OSQTsSrc;         /* OS_TS_GET() when the flow of the message started        */
+} OS_Q_TS;
+#endif
+
+#if OS_Q_PRIO_EN > 0
+typedef struct os_q_msg {
+    struct os_q_msg  *OSQMsgNext;       /* Next message of the same priority, or next free entry   */
+    void             *OSQMsgPtr;        /* Message                                                 */
+#if OS_Q_TRACE_EN > 0
+    OS_Q_TS           OSQMsgTs;         /* Timestamps of the message                               */
+#endif
+} OS_Q_MSG;
+
+typedef struct os_q_prio {
+    OS_Q_MSG   *OSQPrioFreeList;                    /* List of free message entries            */
+    INT32U      OSQPrioRdyTbl;                      /* Bit n set if level n holds messages     */
+    OS_Q_MSG   *OSQPrioHead[OS_Q_PRIO_LVLS];        /* Oldest message of each level            */
+    OS_Q_MSG   *OSQPrioTail[OS_Q_PRIO_LVLS];        /* Newest message of each level            */
+} OS_Q_PRIO;
+#endif
+
 typedef struct os_event {
     void    *OSEventPtr;                /* Pointer to message or queue structure                   */
     INT32U   OSEventWaitTbl;            /* List of tasks waiting for event to occur                */
@@ -115,7 +251,30 @@ typedef struct os_event {
     void         **OSQOut;              /* Pointer to where next message will be extracted from the Q  */
     INT16U         OSQSize;             /* Size of queue (maximum number of entries)                   */
     INT16U         OSNMsgs;             /* Current number of of messages in message queue                      */
-    
+#if OS_EVENT_TYPE_EN > 0
+    INT8U          OSEventType;         /* Type of event control block (see OS_EVENT_TYPE_xxxx)        */
+#endif
+
+#if OS_STAT_EN > 0
+    INT16U         OSNMsgsPeak;         /* Highest number of messages in the queue                     */
+    INT32U         OSEventPostCtr;      /* Number of messages posted                                   */
+    INT32U         OSEventPendCtr;      /* Number of pend calls                                        */
+    INT32U         OSEventTOCtr;        /* Number of pend calls which timed out                        */
+    INT32U         OSEventHandoffCtr;   /* Number of messages handed directly to a waiting task        */
+    INT32U         OSEventBlockMax;     /* Longest time a task was blocked on the queue (ticks)        */
+#endif
+
+#if OS_Q_TRACE_EN > 0
+    INT8U          OSQTraceOn;          /* Messages posted to the queue are traced                     */
+    OS_Q_TS       *OSQTraceTs;          /* Timestamps of the ring entries, parallel to OSQStart[]      */
+    INT32U         OSQTraceCtr;         /* Number of messages traced                                   */
+    INT32U         OSQTraceResMin;      /* Time spent in the queue, post to pend (CPU cycles)          */
+    INT32U         OSQTraceResMax;
+    INT64U         OSQTraceResSum;
+    INT32U         OSQTraceE2EMin;      /* Time since the start of the flow, source to pend (CPU cycles)*/
+    INT32U         OSQTraceE2EMax;
+    INT64U         OSQTraceE2ESum;
+#endif
 } OS_EVENT;
 
 OS_EXT  OS_EVENT  *OSEventFreeList;          /* Pointer to list of free EVENT control blocks    */
@@ -131,6 +290,275 @@ OS_EXT  OS_EVENT   OSEventTbl[OS_MAX_QS];    /* Table of EVENT control blocks
 OS_EVENT   *OSQCreate (void **start,  INT16U size);
 void 	   *OSQPend (OS_EVENT *pevent, INT16U timeout, INT8U *perr);
 INT8U 	    OSQPost (OS_EVENT *pevent, void *pmsg);
+void       *OSQPendAny (OS_EVENT **pevents, INT8U nevents, INT16U timeout, INT8U *pwhich, INT8U *perr);
+INT8U       OSQPostFront (OS_EVENT *pevent, void *pmsg);
+INT8U       OSQPostOpt (OS_EVENT *pevent, void *pmsg, INT8U opt);
+
+#if OS_Q_PRIO_EN > 0
+OS_EVENT   *OSQPrioCreate (OS_Q_PRIO *pqprio, OS_Q_MSG *start, INT16U size);
+INT8U       OSQPostPrio (OS_EVENT *pevent, void *pmsg, INT8U prio);
+#endif
+
+#if OS_STAT_EN > 0
+typedef struct os_event_data {
+    OS_EVENT      *OSEventPtr;          /* Event control block this snapshot was taken from            */
+    INT32U         OSEventWaitTbl;      /* List of tasks waiting on the queue                          */
+    INT16U         OSQSize;             /* Size of queue                                               */
+    INT16U         OSNMsgs;             /* Number of messages in the queue                             */
+    INT16U         OSNMsgsPeak;
+    INT32U         OSEventPostCtr;
+    INT32U         OSEventPendCtr;
+    INT32U         OSEventTOCtr;
+    INT32U         OSEventHandoffCtr;
+    INT32U         OSEventBlockMax;
+} OS_EVENT_DATA;
+
+OS_EVENT   *OSEventNext (OS_EVENT *pevent, OS_EVENT_DATA *pdata);
+#endif
+
+#if OS_Q_TRACE_EN > 0
+/*
+*  A traced message carries two timestamps: when it was posted, and when its flow started.  A message
+*  posted by an ISR (or by a task which has not received a traced message) starts a flow; a task which
+*  posts after receiving a traced message passes the start of the flow on.  For each queue, the receiver
+*  accounts the residence (post to pend) and the end-to-end latency (start of the flow to pend).
+*  OSQTracePipeline() sums the residences of the queues: the summed Min/Max are bounds, not the min/max
+*  of the residence of a message through the pipeline, which is not observed.
+*/
+typedef struct os_q_trace_data {
+    INT32U         OSQTraceCtr;         /* Number of messages traced                               */
+    INT32U         OSQTraceResMin;      /* Residence in the queue(s) (CPU cycles)                  */
+    INT32U         OSQTraceResAvg;
+    INT32U         OSQTraceResMax;
+    INT32U         OSQTraceE2EMin;      /* Start of the flow to the receiver (CPU cycles)          */
+    INT32U         OSQTraceE2EAvg;
+    INT32U         OSQTraceE2EMax;
+} OS_Q_TRACE_DATA;
+
+void        OSQTraceStart    (OS_EVENT *pevent, OS_Q_TS *pts);
+void        OSQTraceQuery    (OS_EVENT *pevent, OS_Q_TRACE_DATA *pdata, INT8U reset);
+void        OSQTracePipeline (OS_EVENT **pevents, INT8U nevents, OS_Q_TRACE_DATA *pdata);
+#endif
+
+#endif
+
+#if OS_HEAP_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                            HEAP MANAGEMENT
+*
+*  Two-level segregated fit allocator: OSHeapAlloc() and OSHeapFree() run in bounded, constant time.
+*  They lock the scheduler but leave interrupts enabled, so they MUST NOT be called from an ISR.  Each
+*  block is charged to the task which allocated it.
+*********************************************************************************************************
+*/
+
+#if OS_SCHED_LOCK_EN == 0
+#error "OS_HEAP_EN requires OS_SCHED_LOCK_EN"
+#endif
+
+typedef struct os_heap_data {
+    INT32U   OSHeapSize;                /* Size of the heap (bytes)                                */
+    INT32U   OSHeapUsed;                /* Bytes allocated, block headers included                 */
+    INT32U   OSHeapUsedPeak;            /* Highest value reached by OSHeapUsed                     */
+    INT32U   OSHeapFree;                /* Bytes available in free blocks                          */
+    INT32U   OSHeapMaxFree;             /* Size of the largest free block                          */
+    INT16U   OSHeapNFree;               /* Number of free blocks                                   */
+    INT16U   OSHeapFrag;                /* Fragmentation in 1/1000 (1000 - 1000*MaxFree/Free)      */
+} OS_HEAP_DATA;
+
+void       *OSHeapAlloc    (INT32U size);
+void        OSHeapFree     (void *pmem);
+void        OSHeapQuery    (OS_HEAP_DATA *pdata);
+INT32U      OSHeapTaskUsed (INT8U prio, INT32U *ppeak);
+
+#endif
+
+#if OS_WORK_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        DEFERRED WORK MANAGEMENT
+*
+*  An ISR hands a job {function, argument} over to a worker task with OSWorkPost() instead of doing the
+*  work itself.  A work queue is a regular message queue (see OSQCreate()) drained by one or more worker
+*  tasks calling OSWorkRun(); OSWorkQ is the one served by the kernel worker task.  A job which is
+*  already pending is not queued twice, so a queue never holds more entries than there are OS_WORKs.
+*********************************************************************************************************
+*/
+
+#if OS_Q_EN == 0
+#error "OS_WORK_EN requires OS_Q_EN"
+#endif
+
+typedef struct os_work {
+    void   (*OSWorkFnct)(void *parg);   /* Function to run in the worker task                      */
+    void    *OSWorkArg;                 /* Argument passed to OSWorkFnct                           */
+    INT8U    OSWorkPending;             /* 1 while the job sits in a work queue                    */
+} OS_WORK;
+
+OS_EXT  OS_EVENT  *OSWorkQ;                  /* Work queue served by the kernel worker task     */
+
+void        OSWorkInit (OS_WORK *pwork, void (*fnct)(void *parg), void *parg);
+INT8U       OSWorkPost (OS_EVENT *pevent, OS_WORK *pwork);
+void        OSWorkRun  (OS_EVENT *pevent);
+
+#endif
+
+#if OS_STREAM_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        STREAM BUFFER MANAGEMENT
+*
+*  A stream buffer is a byte ring with ONE writer (task, ISR or DMA) and ONE reader task.  Data is copied
+*  outside of critical sections, only the indexes are updated with interrupts disabled.  The reader
+*  blocks while the buffer is empty and is woken up once OSStreamTrigLevel bytes are available.
+*********************************************************************************************************
+*/
+
+typedef struct os_stream {
+    INT32U             OSStreamWaitTbl;     /* List of tasks waiting for data                      */
+    INT8U             *OSStreamBuf;         /* Pointer to start of stream data                     */
+    INT16U             OSStreamSize;        /* Size of stream data (bytes)                         */
+    INT16U             OSStreamIn;          /* Index where next byte will be inserted (writer)     */
+    INT16U             OSStreamOut;         /* Index where next byte will be extracted (reader)    */
+    INT16U             OSStreamNBytes;      /* Current number of bytes in the stream               */
+    INT16U             OSStreamTrigLevel;   /* Nbr of bytes needed to wake up the reader           */
+    struct os_stream  *OSStreamNext;        /* Pointer to next free stream buffer                  */
+} OS_STREAM;
+
+OS_EXT  OS_STREAM  *OSStreamFreeList;                 /* Pointer to list of free stream buffers  */
+OS_EXT  OS_STREAM   OSStreamTbl[OS_MAX_STREAMS];      /* Table of stream buffers                 */
+
+OS_STREAM  *OSStreamCreate      (INT8U *buf, INT16U size, INT16U trig);
+INT16U      OSStreamWrite       (OS_STREAM *pstream, const void *pdata, INT16U len);
+INT8U      *OSStreamWriteClaim  (OS_STREAM *pstream, INT16U *plen);
+void        OSStreamWriteCommit (OS_STREAM *pstream, INT16U len);
+INT16U      OSStreamRead        (OS_STREAM *pstream, void *pdata, INT16U len, INT16U timeout, INT8U *perr);
+
+#endif
+
+#if OS_IPC_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                     INTER-PROCESSOR CHANNEL MANAGEMENT
+*
+*  A channel carries messages (pointer sized words, as with queues) from ONE producer on one processor
+*  to ONE consumer on the other, through an OS_IPC_SHM ring placed in memory shared by both.  Each
+*  processor runs its own MinOS and opens its end of the channel with OSIPCCreate():
+*
+*  - The producer writes messages with OSIPCWrite() and publishes them with OSIPCCommit(), or does both
+*    with OSIPCPost().  A commit rings the doorbell of the peer, see OS_IPC_Doorbell().
+*  - The consumer waits with OSIPCPend().  The doorbell interrupt of the consumer processor calls
+*    OSIPCNotify(), which hands the messages to the waiting tasks as OSQPost() would.
+*
+*  No lock is shared between the processors: the head is only written by the producer, the tail only by
+*  the consumer, and both sit in their own cache line.  OS_IPC_SHM is aligned on OS_IPC_CACHE_LINE, a
+*  region placed by the linker or allocated MUST be aligned as well, and non-cacheable (or kept coherent
+*  by hardware).  The producer end MUST be created before the consumer processor uses the channel.
+*********************************************************************************************************
+*/
+
+#if OS_Q_EN == 0
+#error "OS_IPC_EN requires OS_Q_EN"
+#endif
+#if (OS_IPC_SLOTS & (OS_IPC_SLOTS - 1)) != 0
+#error "OS_IPC_SLOTS must be a power of 2"
+#endif
+
+#define  OS_IPC_CACHE_LINE           32u    /* Size of a cache line (bytes)                            */
+
+typedef struct __attribute__((aligned(OS_IPC_CACHE_LINE))) os_ipc_shm {
+    volatile INT32U   OSIPCHead;                            /* Messages committed (producer only)  */
+    INT8U             OSIPCPad0[OS_IPC_CACHE_LINE - 4u];
+    volatile INT32U   OSIPCTail;                            /* Messages consumed (consumer only)   */
+    INT8U             OSIPCPad1[OS_IPC_CACHE_LINE - 4u];
+    INT8U             OSIPCId;                              /* Channel number given to the doorbell*/
+    INT8U             OSIPCPad2[OS_IPC_CACHE_LINE - 1u];
+    void * volatile   OSIPCSlot[OS_IPC_SLOTS];              /* Messages                            */
+} OS_IPC_SHM;
+
+OS_EVENT   *OSIPCCreate   (OS_IPC_SHM *pshm, INT8U id, INT8U type);
+INT8U       OSIPCWrite    (OS_EVENT *pevent, void *pmsg);
+void        OSIPCCommit   (OS_EVENT *pevent);
+INT8U       OSIPCPost     (OS_EVENT *pevent, void *pmsg);
+void       *OSIPCPend     (OS_EVENT *pevent, INT16U timeout, INT8U *perr);
+void        OSIPCNotify   (OS_EVENT *pevent);
+void        OS_IPC_Doorbell (INT8U id);
+
+#endif
+
+#if OS_STATIC_CFG_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          STATIC CONFIGURATION
+*
+*  Tasks and queues listed in OS_STATIC_TASK_TBL and OS_STATIC_Q_TBL exist as soon as OSInit() returns.
+*  The kernel worker task and OSWorkQ are part of the static configuration when OS_WORK_EN is set.
+*********************************************************************************************************
+*/
+
+#define  OS_STATIC_STK_MIN           32u    /* Smallest stack of a static task (# of OS_STK entries)   */
+
+#define  OS_TASK_DECL(name, prio, stk)      void name (void);
+OS_STATIC_TASK_TBL(OS_TASK_DECL)
+
+#if OS_Q_EN > 0
+#define  OS_Q_IDX_DECL(name, size)          OS_Q_IDX_##name,
+enum os_q_idx {
+#if OS_WORK_EN > 0
+    OS_Q_IDX_OSWorkQ,
+#endif
+    OS_STATIC_Q_TBL(OS_Q_IDX_DECL)
+    OS_Q_STATIC_CNT                         /* Number of ECBs used by static queues                    */
+};
+
+#define  OS_Q(name)                         (&OSEventTbl[OS_Q_IDX_##name])
+#endif
+
+#endif
+
+#if OS_HRT_EN > 0
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                       HIGH RESOLUTION TIMEOUTS
+*
+*  Timeouts below the tick period are driven by a free-running 32-bit timer with a compare interrupt.
+*  Deadlines are kept in a sorted list and only the earliest one is armed.  A timeout MUST be less than
+*  2^31 timer counts: longer timeouts are clamped to OS_HRT_US_MAX microseconds.  The port functions
+*  below are implemented on TIM2 in minos.c; they are declared weak so that another timer (or a host
+*  simulation) can replace them.
+*
+*  OS_HRT_Init()            : Start the timer, compare interrupt disabled
+*  OS_HRT_Now()             : Return the current value of the counter
+*  OS_HRT_Arm(deadline)     : Request OS_HRT_Handler() when the counter reaches 'deadline'
+*  OS_HRT_Disarm()          : Cancel the request and clear a pending compare interrupt
+*********************************************************************************************************
+*/
+
+#define  OS_HRT_US_MAX               ((0x80000000u / OS_HRT_TICKS_PER_US) - 1u)   /* Longest timeout (us) */
+
+void        OS_HRT_Init   (void);
+INT32U      OS_HRT_Now    (void);
+void        OS_HRT_Arm    (INT32U deadline);
+void        OS_HRT_Disarm (void);
+
+void        OSTimeDlyUs   (INT32U us);
+#if OS_Q_EN > 0
+void       *OSQPendUs     (OS_EVENT *pevent, INT32U us, INT8U *perr);
+void       *OSQPendAnyUs  (OS_EVENT **pevents, INT8U nevents, INT32U us, INT8U *pwhich, INT8U *perr);
+#endif
+#if OS_STREAM_EN > 0
+INT16U      OSStreamReadUs(OS_STREAM *pstream, void *pdata, INT16U len, INT32U us, INT8U *perr);
+#endif
+#if OS_IPC_EN > 0
+void       *OSIPCPendUs   (OS_EVENT *pevent, INT32U us, INT8U *perr);
+#endif
 
 #endif
 
@@ -140,6 +568,14 @@ INT8U 	    OSQPost (OS_EVENT *pevent, void *pmsg);
 *********************************************************************************************************
 */
 OS_EXT  INT8U      OSIntNesting;                    /* Interrupt nesting level                  */
+OS_EXT  INT32U     OSCtxSwCtr;                      /* Counter of context switches              */
+#if OS_SCHED_LOCK_EN > 0
+OS_EXT  INT8U      OSLockNesting;                   /* Multitasking lock nesting level          */
+OS_EXT  INT8U      OSSchedPend;                     /* Reschedule deferred until unlocked       */
+#endif
+#if OS_STAT_EN > 0
+OS_EXT  volatile  INT32U  OSTime;                   /* Current value of system time (in ticks)  */
+#endif
 
 /*
 *********************************************************************************************************
@@ -148,16 +584,80 @@ OS_EXT  INT8U      OSIntNesting;                    /* Interrupt nesting level
 */
 
 void OSTimeDly          (INT16U ticks);
+void OSTimeTickHook     (void);
+#if OS_AO_EN > 0
+void OS_AOTick          (void);                  /* Time events of the active objects (minos_ao.c)     */
+#endif
 
 void OSInit             (void);
 void OSTaskCreate       (void (*task)(void), OS_STK *ptos, INT8U prio);
 void OSStart            (void);
+INT8U OSTaskPrioGet     (void);
+
+#if OS_SCHED_LOCK_EN > 0
+void OSSchedLock        (void);
+void OSSchedUnlock      (void);
+#endif
+
+#if OS_STAT_EN > 0
+typedef struct os_task_data {
+    INT8U          OSTaskPrio;          /* Task priority                                           */
+    INT8U          OSTaskStat;          /* Task status (see OS_STAT_xxxx)                          */
+    INT8U          OSTaskRdy;           /* 1 if the task is in the ready list                      */
+    INT16U         OSTaskDly;           /* Ticks left to delay or to timeout                       */
+#if OS_Q_EN > 0
+    OS_EVENT      *OSTaskEventPtr;      /* Queue the task is pending on                            */
+#endif
+} OS_TASK_DATA;
+
+INT8U OSTaskNext        (INT8U prio, OS_TASK_DATA *pdata);
+#endif
+
+#if OS_LAT_EN > 0
+#define  OS_LAT_BUCKETS          24u    /* Bucket i counts latencies of [2^i, 2^(i+1)) CPU cycles      */
+
+typedef struct os_lat_data {
+    INT32U         OSLatCtr;            /* Number of wake-ups measured                             */
+    INT32U         OSLatMax;            /* Longest wake-to-run latency (CPU cycles)                */
+    INT32U         OSLatP99;            /* 99th percentile, upper bound of its bucket (CPU cycles) */
+    INT32U         OSLatHist[OS_LAT_BUCKETS];   /* Log2 histogram, last bucket also counts longer  */
+} OS_LAT_DATA;
+
+void  OSTaskLatGet      (INT8U prio, OS_LAT_DATA *pdata, INT8U reset);
+#endif
+
+#if OS_TASK_BASIC_EN > 0
+void  OSTaskCreateBasic (void (*task)(void), INT8U prio);
+void  OSTaskActivate    (INT8U prio);
+#endif
+
+#if (OS_LAT_EN > 0) || (OS_TASK_BASIC_EN > 0)
+void  OS_TaskSwHook     (void);
+#endif
+#if OS_TASK_BASIC_EN > 0
+void  OS_TaskBasicDirect(void);
+void  OS_TaskBasicCall  (OS_STK *ptos);
+#endif
+
+#if OS_PREEMPT_THRESH_EN > 0
+void  OSTaskCreateExt   (void (*task)(void), OS_STK *ptos, INT8U prio, INT8U thresh);
+INT8U OSTaskThreshSet   (INT8U prio, INT8U thresh);
+#endif
 
 #define OSTask_Create(task)      OSTaskCreate (task, \
                                               &task##_Stk[ \
                                                task##_STK_SIZE - 1 ], \
                                                task##_PRIO)
 
+#if OS_PREEMPT_THRESH_EN > 0
+#define OSTask_CreateExt(task)   OSTaskCreateExt (task, \
+                                              &task##_Stk[ \
+                                               task##_STK_SIZE - 1 ], \
+                                               task##_PRIO, \
+                                               task##_THRESH)
+#endif
+
+void     OS_Sched (void);
 #define  OSIntEnter()                   {if(OSIntNesting < 255u) OSIntNesting++;}
 #define  OSIntExit()                    {if(OSIntNesting >   0 ) OSIntNesting--;OS_Sched();}
 
@@ -0,0 +1,507 @@
+/*
+*********************************************************************************************************
+*                                                MinOS
+*                                          The Real-Time Kernel
+*                                      ACTIVE OBJECT FRAMEWORK
+*
+*                              (c) Copyright 2018-2020, Windy Albert
+*                                           All Rights Reserved
+*
+* File    : MINOS_AO.C
+* By      : Windy Albert
+* Version : V2.00
+*
+*********************************************************************************************************
+*/
+
+#include <minos_ao.h>
+
+#if OS_AO_EN > 0
+/*
+*********************************************************************************************************
+*                                            LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef struct os_ao_pool {
+    void                *OSAOPoolFreeList;  /* Pointer to list of free events                         */
+    INT16U               OSAOPoolEvtSize;   /* Size of the events of the pool (bytes)                  */
+    INT16U               OSAOPoolNFree;     /* Number of free events                                   */
+} OS_AO_POOL;
+
+/*
+*********************************************************************************************************
+*                                            LOCAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  OS_AO_POOL   OSAOPoolTbl[OS_AO_MAX_POOLS];  /* Event pools, by increasing event size     */
+static  INT8U        OSAOPoolCnt;                   /* Number of pools initialized               */
+static  INT32U       OSAOSubTbl[OS_AO_MAX_SIGS];    /* Subscribers (priorities) of each signal   */
+static  OS_AO       *OSAOTbl[OS_TASK_IDLE_PRIO];    /* Active objects, by priority               */
+static  OS_AO_TEVT  *OSAOTEvtList;                  /* List of the time events                   */
+
+static  const OS_AO_EVT  OSAOEntryEvt = { OS_AO_SIG_ENTRY, 0, 0 };
+static  const OS_AO_EVT  OSAOExitEvt  = { OS_AO_SIG_EXIT,  0, 0 };
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                   DISPATCH AN EVENT TO AN ACTIVE OBJECT
+*
+* Description: This function hands an event to the current state of an active object.  If the state
+*              took a transition (see OS_AO_TRAN()), the state left gets OS_AO_SIG_EXIT and the new state
+*              gets OS_AO_SIG_ENTRY.  This function is INTERNAL to MinOS.
+*
+* Arguments  : me            is a pointer to the active object
+*
+*              e             is a pointer to the event
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_AODispatch (OS_AO *me, const OS_AO_EVT *e)
+{
+    OS_AO_HANDLER  s;
+    OS_AO_HANDLER  t;
+
+    s = me->OSAOState;
+    (*s)(me, e);
+    while (me->OSAOState != s) {                 /* Transition taken                                   */
+        t             = me->OSAOState;
+        me->OSAOState = s;
+        (*s)(me, &OSAOExitEvt);                  /* Exit the source state ...                          */
+        me->OSAOState = t;
+        (*t)(me, &OSAOEntryEvt);                 /* ... and enter the target (may transition again)    */
+        s             = t;
+    }
+}
+
+/*
+*********************************************************************************************************
+*                                         ACTIVE OBJECT TASK
+*
+* Description: This task is shared by all the active objects.  It finds its active object by priority and
+*              runs the event loop: wait for an event, run it to completion, recycle it.
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+static void  OS_AOTask (void)
+{
+    OS_AO            *me;
+    const OS_AO_EVT  *e;
+    INT8U             err;
+
+    me = OSAOTbl[OSTaskPrioGet()];
+    OS_AODispatch(me, &OSAOEntryEvt);            /* Enter the initial state                            */
+    for (;;) {
+        e = (const OS_AO_EVT *)OSQPend(me->OSAOQ, 0, &err);
+        OS_AODispatch(me, e);
+        OSAOGc(e);                               /* This AO is done with the event                     */
+    }
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                        START AN ACTIVE OBJECT
+*
+* Description: This function creates the event queue and the task of an active object.  Like tasks, active
+*              objects MUST be started before OSStart().
+*
+* Arguments  : me            is a pointer to the active object
+*
+*              initial       is the initial state handler.  It gets OS_AO_SIG_ENTRY when the task starts.
+*
+*              prio          is the priority of the task of the active object (< OS_TASK_IDLE_PRIO)
+*
+*              qsto          is the storage of the event queue, an array of 'qlen' pointers to 'void'
+*
+*              qlen          is the number of entries of the event queue
+*
+*              ptos          is a pointer to the top of stack of the task
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSAOStart (OS_AO *me, OS_AO_HANDLER initial, INT8U prio, void **qsto, INT16U qlen, OS_STK *ptos)
+{
+    if (prio >= OS_TASK_IDLE_PRIO) {
+        while(1);                                /* Error: Minos Panic OS_ERR_PRIO_INVALID             */
+    }
+    me->OSAOState = initial;
+    me->OSAOQ     = OSQCreate(qsto, qlen);
+    me->OSAOPrio  = prio;
+    OSAOTbl[prio] = me;
+    OSTaskCreate(OS_AOTask, ptos, prio);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                       INITIALIZE AN EVENT POOL
+*
+* Description: This function splits a storage area in fixed-size events.  Pools MUST be initialized by
+*              increasing event size, OSAONewEvt() takes an event from the first pool large enough.
+*
+* Arguments  : psto          is a pointer to the storage area of the pool (aligned on a pointer)
+*
+*              stosize       is the size of the storage area (bytes)
+*
+*              evtsize       is the size of the events of the pool (bytes), rounded up to a multiple of
+*                            the size of a pointer
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSAOPoolInit (void *psto, INT32U stosize, INT16U evtsize)
+{
+    OS_AO_POOL  *ppool;
+    INT8U       *pblk;
+    void        *pfree;
+    INT16U       nfree;
+
+    evtsize = (INT16U)((evtsize + sizeof(void *) - 1u) & ~(sizeof(void *) - 1u));
+    if ((OSAOPoolCnt >= OS_AO_MAX_POOLS) ||      /* Too many pools or not by increasing size           */
+        ((OSAOPoolCnt > 0) && (evtsize <= OSAOPoolTbl[OSAOPoolCnt - 1u].OSAOPoolEvtSize))) {
+        while(1);
+    }
+
+    pblk  = (INT8U *)psto;
+    pfree = (void *)0;
+    nfree = 0;
+    while (stosize >= evtsize) {                 /* Link all the events of the storage area            */
+        *(void **)pblk  = pfree;
+        pfree           = pblk;
+        pblk           += evtsize;
+        stosize        -= evtsize;
+        nfree++;
+    }
+
+    ppool                   = &OSAOPoolTbl[OSAOPoolCnt];
+    ppool->OSAOPoolFreeList = pfree;
+    ppool->OSAOPoolEvtSize  = evtsize;
+    ppool->OSAOPoolNFree    = nfree;
+    OSAOPoolCnt++;
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          ALLOCATE AN EVENT
+*
+* Description: This function takes an event from the smallest pool whose events can hold 'evtsize' bytes.
+*              It can be called from a task or an ISR.
+*
+* Arguments  : evtsize       is the size of the event (bytes), OS_AO_EVT included
+*
+*              sig           is the signal of the event
+*
+* Returns    : A pointer to the event.  The function CANNOT return normally if the pool is empty.
+*
+* Note(s)    : The event goes back to its pool when the last active object it was posted to is done with
+*              it.  An event which is never posted MUST be given back with OSAOGc().
+*********************************************************************************************************
+*/
+
+OS_AO_EVT  *OSAONewEvt (INT16U evtsize, OS_AO_SIG sig)
+{
+    OS_AO_POOL  *ppool;
+    OS_AO_EVT   *e;
+    INT8U        i;
+    OS_CPU_SR    cpu_sr = 0;
+
+    i = 0;
+    while ((i < OSAOPoolCnt) && (OSAOPoolTbl[i].OSAOPoolEvtSize < evtsize)) {
+        i++;
+    }
+    if (i == OSAOPoolCnt) {
+        while(1);                                /* No pool with events large enough                   */
+    }
+    ppool = &OSAOPoolTbl[i];
+
+    OS_ENTER_CRITICAL();
+    e = (OS_AO_EVT *)ppool->OSAOPoolFreeList;
+    if (e == (OS_AO_EVT *)0) {
+        OS_EXIT_CRITICAL();
+        while(1);                                /* Pool exhausted, give it more events                */
+    }
+    ppool->OSAOPoolFreeList = *(void **)e;
+    ppool->OSAOPoolNFree--;
+    OS_EXIT_CRITICAL();
+
+    e->OSAOEvtSig    = sig;
+    e->OSAOEvtPool   = (INT8U)(i + 1u);
+    e->OSAOEvtRefCtr = 0;
+    return (e);
+}
+
+/*
+*********************************************************************************************************
+*                                           RECYCLE AN EVENT
+*
+* Description: This function drops one reference to an event.  The event goes back to its pool when no
+*              queue holds it any more.  Static events are left untouched.
+*
+* Arguments  : e             is a pointer to the event
+*
+* Returns    : none
+*
+* Note(s)    : Only events allocated by OSAONewEvt() are written to, so the const qualifier is cast away
+*              for them alone.  Static events may be kept in flash.
+*********************************************************************************************************
+*/
+
+void  OSAOGc (const OS_AO_EVT *e)
+{
+    OS_AO_EVT   *pdyn;
+    OS_AO_POOL  *ppool;
+    OS_CPU_SR    cpu_sr = 0;
+
+    if (e->OSAOEvtPool == 0) {                   /* Static event                                       */
+        return;
+    }
+    pdyn = (OS_AO_EVT *)e;                       /* Dynamic event, it lives in a pool in RAM           */
+    OS_ENTER_CRITICAL();
+    if (pdyn->OSAOEvtRefCtr > 1) {
+        pdyn->OSAOEvtRefCtr--;                   /* Still held by other queues                         */
+    } else {
+        ppool                   = &OSAOPoolTbl[pdyn->OSAOEvtPool - 1u];
+        *(void **)pdyn          = ppool->OSAOPoolFreeList;
+        ppool->OSAOPoolFreeList = pdyn;          /* Last reference: back to the pool                   */
+        ppool->OSAOPoolNFree++;
+    }
+    OS_EXIT_CRITICAL();
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                    POST AN EVENT TO AN ACTIVE OBJECT
+*
+* Description: This function posts an event to the queue of an active object.  It can be called from a
+*              task or an ISR.
+*
+* Arguments  : me            is a pointer to the active object
+*
+*              e             is a pointer to the event
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSAOPost (OS_AO *me, const OS_AO_EVT *e)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (e->OSAOEvtPool != 0) {
+        OS_ENTER_CRITICAL();
+        ((OS_AO_EVT *)e)->OSAOEvtRefCtr++;       /* One more queue holds the (dynamic) event           */
+        OS_EXIT_CRITICAL();
+    }
+    OSQPost(me->OSAOQ, (void *)e);
+}
+
+/*
+*********************************************************************************************************
+*                                   SUBSCRIBE/UNSUBSCRIBE TO A SIGNAL
+*
+* Description: These functions add or remove an active object from the subscribers of a signal.
+*
+* Arguments  : me            is a pointer to the active object
+*
+*              sig           is the signal ( < OS_AO_MAX_SIGS )
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSAOSubscribe (OS_AO *me, OS_AO_SIG sig)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (sig >= OS_AO_MAX_SIGS) {
+        while(1);
+    }
+    OS_ENTER_CRITICAL();
+    OSAOSubTbl[sig] |=  ( 1u << me->OSAOPrio );
+    OS_EXIT_CRITICAL();
+}
+
+void  OSAOUnsubscribe (OS_AO *me, OS_AO_SIG sig)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (sig >= OS_AO_MAX_SIGS) {
+        while(1);
+    }
+    OS_ENTER_CRITICAL();
+    OSAOSubTbl[sig] &= ~( 1u << me->OSAOPrio );
+    OS_EXIT_CRITICAL();
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                           PUBLISH AN EVENT
+*
+* Description: This function posts an event to every active object which subscribed to its signal, from
+*              the highest priority one.  It can be called from a task or an ISR.
+*
+* Arguments  : e             is a pointer to the event
+*
+* Returns    : none
+*
+* Note(s)    : 1) The publisher holds a reference while the event is multicast, so a subscriber which
+*                 preempts the publisher cannot recycle it before the other subscribers got it.  An event
+*                 nobody subscribed to is recycled at once.
+*              2) With OS_SCHED_LOCK_EN, subscribers only run once the event has been posted to all.
+*********************************************************************************************************
+*/
+
+void  OSAOPublish (const OS_AO_EVT *e)
+{
+    INT32U     subs;
+    INT8U      prio;
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (e->OSAOEvtSig >= OS_AO_MAX_SIGS) {
+        while(1);
+    }
+    OS_ENTER_CRITICAL();
+    subs = OSAOSubTbl[e->OSAOEvtSig];
+    if (e->OSAOEvtPool != 0) {
+        ((OS_AO_EVT *)e)->OSAOEvtRefCtr++;       /* Hold the event until it has been multicast         */
+    }
+    OS_EXIT_CRITICAL();
+
+#if OS_SCHED_LOCK_EN > 0
+    OSSchedLock();
+#endif
+    while (subs != 0) {
+        prio  = (INT8U) CPU_CntTrailZeros( subs );
+        subs &= ~( 1u << prio );
+        OSAOPost(OSAOTbl[prio], e);
+    }
+#if OS_SCHED_LOCK_EN > 0
+    OSSchedUnlock();
+#endif
+
+    OSAOGc(e);                                   /* Drop the reference of the publisher                */
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                         INITIALIZE A TIME EVENT
+*
+* Description: This function initializes a (disarmed) time event.  Once armed, a time event posts itself
+*              to its active object when it expires.
+*
+* Arguments  : te            is a pointer to the time event
+*
+*              me            is a pointer to the active object the time event is posted to
+*
+*              sig           is the signal of the time event
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OSAOTEvtInit (OS_AO_TEVT *te, OS_AO *me, OS_AO_SIG sig)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    te->OSAOTEvtSuper.OSAOEvtSig    = sig;
+    te->OSAOTEvtSuper.OSAOEvtPool   = 0;        /* Time events are static                             */
+    te->OSAOTEvtSuper.OSAOEvtRefCtr = 0;
+    te->OSAOTEvtAO                  = me;
+    te->OSAOTEvtCtr                 = 0;
+    te->OSAOTEvtInterval            = 0;
+
+    OS_ENTER_CRITICAL();
+    te->OSAOTEvtNext                = OSAOTEvtList;
+    OSAOTEvtList                    = te;
+    OS_EXIT_CRITICAL();
+}
+
+/*
+*********************************************************************************************************
+*                                      ARM/DISARM A TIME EVENT
+*
+* Description: OSAOTEvtArm() (re)arms a time event to expire in 'ticks' ticks, then every 'interval'
+*              ticks if 'interval' is not 0.  OSAOTEvtDisarm() stops it.
+*
+* Arguments  : te            is a pointer to the time event
+*
+*              ticks         is the number of ticks before the first expiry ( > 0 )
+*
+*              interval      is the period of a periodic time event, 0 for a one-shot time event
+*
+* Returns    : OSAOTEvtDisarm() returns 1 if the time event was armed, 0 if it had already expired.
+*
+* Note(s)    : A time event which expired may still be in the queue of its active object.
+*********************************************************************************************************
+*/
+
+void  OSAOTEvtArm (OS_AO_TEVT *te, INT32U ticks, INT32U interval)
+{
+    OS_CPU_SR  cpu_sr = 0;
+
+    if (ticks == 0) {
+        while(1);
+    }
+    OS_ENTER_CRITICAL();
+    te->OSAOTEvtCtr      = ticks;
+    te->OSAOTEvtInterval = interval;
+    OS_EXIT_CRITICAL();
+}
+
+INT8U  OSAOTEvtDisarm (OS_AO_TEVT *te)
+{
+    INT8U      armed;
+    OS_CPU_SR  cpu_sr = 0;
+
+    OS_ENTER_CRITICAL();
+    armed           = (te->OSAOTEvtCtr != 0) ? 1u : 0u;
+    te->OSAOTEvtCtr = 0;
+    OS_EXIT_CRITICAL();
+    return (armed);
+}
+
+/*$PAGE*/
+/*
+*********************************************************************************************************
+*                                          PROCESS TIME EVENTS
+*
+* Description: This function is called every tick by OS_SysTick_Handler(), after OSTimeTickHook().  It
+*              counts down the armed time events and posts those which expire to their active object.
+*              This function is INTERNAL to MinOS.
+*
+* Arguments  : none
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+
+void  OS_AOTick (void)
+{
+    OS_AO_TEVT  *te;
+
+    for (te = OSAOTEvtList; te != (OS_AO_TEVT *)0; te = te->OSAOTEvtNext) {
+        if ((te->OSAOTEvtCtr != 0) && (--te->OSAOTEvtCtr == 0)) {
+            te->OSAOTEvtCtr = te->OSAOTEvtInterval;     /* Reload, or disarm a one-shot            */
+            OSAOPost(te->OSAOTEvtAO, &te->OSAOTEvtSuper);
+        }
+    }
+}
+#endif
+
+/********************* (C) COPYRIGHT 2018 Windy Albert **************************** END OF FILE ********/
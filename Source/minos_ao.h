@@ -0,0 +1,108 @@
+/*
+*********************************************************************************************************
+*                                                MinOS
+*                                          The Real-Time Kernel
+*                                      ACTIVE OBJECT FRAMEWORK
+*
+*                              (c) Copyright 2018-2020, Windy Albert
+*                                           All Rights Reserved
+*
+* File    : MINOS_AO.h
+* By      : Windy Albert
+* Version : V2.00
+*
+*********************************************************************************************************
+*/
+
+#ifndef   _MINOS_AO_H
+#define   _MINOS_AO_H
+
+#include "minos.h"
+
+#if OS_AO_EN > 0
+/*
+*********************************************************************************************************
+*                                         ACTIVE OBJECT FRAMEWORK
+*
+*  An active object (AO) is a state machine which owns a MinOS task and a message queue.  The task waits
+*  on the queue and hands each event to the current state handler, which runs to completion before the
+*  next event is taken.  Events are passed by pointer, never copied:
+*
+*  - Dynamic events come from fixed-size pools (OSAONewEvt()).  They carry a reference counter which
+*    counts the queues holding the event, and go back to their pool once the last AO consumed them.
+*  - Static events (a const OS_AO_EVT, or a time event) are never recycled.
+*
+*  OSAOPublish() multicasts an event to every AO which subscribed to its signal.  Time events are
+*  counted down by the kernel tick (OS_AOTick()) and post themselves to their AO on expiry, so
+*  OSTimeTickHook() is left to the application.
+*
+*  An application event embeds OS_AO_EVT as its FIRST member:
+*
+*      typedef struct {
+*          OS_AO_EVT   super;
+*          INT16U      len;
+*          INT8U       data[16];
+*      } RxEvt;
+*
+*      RxEvt *e = (RxEvt *)OSAONewEvt(sizeof(RxEvt), SIG_RX);
+*********************************************************************************************************
+*/
+
+#if OS_Q_EN == 0
+#error "OS_AO_EN requires OS_Q_EN"
+#endif
+
+#define  OS_AO_SIG_ENTRY              0u    /* Sent to a state when it is entered                      */
+#define  OS_AO_SIG_EXIT               1u    /* Sent to a state when it is left                         */
+#define  OS_AO_SIG_USER               2u    /* First signal available to the application               */
+
+typedef  INT16U  OS_AO_SIG;
+
+typedef struct os_ao_evt {
+    OS_AO_SIG            OSAOEvtSig;        /* Signal of the event                                     */
+    INT8U                OSAOEvtPool;       /* Pool of the event (1..OS_AO_MAX_POOLS), 0 if static     */
+    INT8U                OSAOEvtRefCtr;     /* Number of queues holding the event                      */
+} OS_AO_EVT;
+
+typedef struct os_ao  OS_AO;
+
+typedef void (*OS_AO_HANDLER)(OS_AO *me, const OS_AO_EVT *e);
+
+struct os_ao {
+    OS_AO_HANDLER        OSAOState;         /* Current state handler                                   */
+    OS_EVENT            *OSAOQ;             /* Event queue of the active object                        */
+    INT8U                OSAOPrio;          /* Priority of the task of the active object               */
+};
+
+typedef struct os_ao_tevt {
+    OS_AO_EVT            OSAOTEvtSuper;     /* Static event posted on expiry                           */
+    struct os_ao_tevt   *OSAOTEvtNext;      /* Next time event in OSAOTEvtList                         */
+    OS_AO               *OSAOTEvtAO;        /* Active object the event is posted to                    */
+    INT32U               OSAOTEvtCtr;       /* Ticks left before expiry, 0 if disarmed                 */
+    INT32U               OSAOTEvtInterval;  /* Reload value of a periodic time event, 0 for one-shot   */
+} OS_AO_TEVT;
+
+                                            /* Take a state transition from a state handler            */
+#define  OS_AO_TRAN(me, target)       ((me)->OSAOState = (OS_AO_HANDLER)(target))
+
+
+void        OSAOStart       (OS_AO *me, OS_AO_HANDLER initial, INT8U prio,
+                             void **qsto, INT16U qlen, OS_STK *ptos);
+
+void        OSAOPoolInit    (void *psto, INT32U stosize, INT16U evtsize);
+OS_AO_EVT  *OSAONewEvt      (INT16U evtsize, OS_AO_SIG sig);
+void        OSAOGc          (const OS_AO_EVT *e);
+
+void        OSAOPost        (OS_AO *me, const OS_AO_EVT *e);
+void        OSAOSubscribe   (OS_AO *me, OS_AO_SIG sig);
+void        OSAOUnsubscribe (OS_AO *me, OS_AO_SIG sig);
+void        OSAOPublish     (const OS_AO_EVT *e);
+
+void        OSAOTEvtInit    (OS_AO_TEVT *te, OS_AO *me, OS_AO_SIG sig);
+void        OSAOTEvtArm     (OS_AO_TEVT *te, INT32U ticks, INT32U interval);
+INT8U       OSAOTEvtDisarm  (OS_AO_TEVT *te);
+
+#endif
+
+#endif
+/********************* (C) COPYRIGHT 2018 Windy Albert **************************** END OF FILE ********/
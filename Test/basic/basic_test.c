@@ -0,0 +1,154 @@
+/**
+  ******************************************************************************
+  * @file    basic_test.c
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   Host test of the direct call of basic tasks by OSTaskActivate().
+  *
+  *          A normal task activates the basic task Basic_Low, which preempts
+  *          it and is called directly.  An interrupt is taken at the end of
+  *          the first critical section of OSTaskActivate() and activates the
+  *          higher priority basic task Basic_High, dispatched by PendSV.  The
+  *          context of Basic_Low must then be saved on the shared stack, and
+  *          the frame of Basic_High nest below it, whatever the stack of the
+  *          caller.  Basic_Low then activates Basic_Mid, a direct call nested
+  *          on the shared stack.
+  *
+  *          The SP is Basic_SP: OS_TaskBasicCall() and Host_PendSV() below
+  *          stand for their assembly and run the tasks as calls.  MinOS is
+  *          built in this file, which needs its TCBs.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "minos.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define Basic_High_PRIO          1
+#define Basic_Mid_PRIO           2
+#define Basic_Low_PRIO           3
+#define Basic_Caller_PRIO        5
+#define Basic_Caller_STK_SIZE  128
+
+#define BASIC_CHK(cond)     {if (!(cond)) {                                          \
+                                 fprintf(stderr, "basic_test: %d: %s\n", __LINE__, #cond); \
+                                 exit(1);                                            \
+                             }}
+
+/* Private variables ---------------------------------------------------------*/
+static OS_STK   Basic_Caller_Stk[Basic_Caller_STK_SIZE];
+static OS_STK  *Basic_SP;               /* Stack pointer of the running code   */
+static OS_STK  *Basic_LowSP;            /* SP saved when Basic_Low is preempted*/
+static OS_STK  *Basic_HighFrame;        /* Frame built for Basic_High          */
+static INT32U   Basic_HighRuns;
+static INT32U   Basic_MidRuns;
+static INT32U   Basic_LowRuns;
+
+
+#define BASIC_IN_SHARED_STK(p)  (((p) >= &OSTaskBasicStk[0]) && ((p) <= &OSTaskBasicStk[OS_TASK_BASIC_STK_SIZE]))
+
+/**
+  * @brief  		OS_TaskBasicCall() of the host: moves Basic_SP instead of the SP.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void OS_TaskBasicCall(OS_STK *ptos)
+{
+	OS_STK *sp = Basic_SP;
+
+	BASIC_CHK(Host_GetPRIMASK() != 0);      /* Not interruptible before the switch */
+	Basic_SP = ptos;
+	OS_TaskBasicDirect();
+	Basic_SP = sp;
+}
+
+/**
+  * @brief  		PendSV of the host, to a basic task: saves Basic_SP as the
+  *           context, builds the frame (OS_TaskSwHook()), runs the task to
+  *           completion as OS_TaskBasicRun() does and switches back.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Host_PendSV(void)
+{
+	OS_TCB *pprev = OSTCBCur;
+	OS_TCB *ptcb  = OSTCBHighRdy;
+	OS_STK *sp    = Basic_SP;
+	INT32U  bit;
+
+	if (ptcb == pprev) {
+		return;
+	}
+	BASIC_CHK((OSTaskBasicTbl & (1u << ptcb->OSTCBPrio)) != 0);
+	pprev->OSTCBStkPtr = Basic_SP;
+	if (pprev->OSTCBPrio == Basic_Low_PRIO) {
+		Basic_LowSP = Basic_SP;
+	}
+	OS_TaskSwHook();
+	OSTCBCur = ptcb;
+	Basic_HighFrame = ptcb->OSTCBStkPtr;
+	Basic_SP = ptcb->OSTCBStkPtr;
+
+	bit = 1u << ptcb->OSTCBPrio;
+	(*ptcb->OSTCBTask)();
+	OSRdyTbl          &= ~bit;
+	OSTaskBasicRunTbl &= ~bit;
+
+	Basic_SP     = sp;
+	OSTCBCur     = pprev;
+	OSTCBHighRdy = pprev;
+}
+
+static void Basic_ISR(void)
+{
+	OSIntEnter();
+	OSTaskActivate(Basic_High_PRIO);        /* From an ISR: PendSV                 */
+	OSIntExit();
+}
+
+static void Basic_High(void)
+{
+	Basic_HighRuns++;
+}
+
+static void Basic_Mid(void)
+{
+	BASIC_CHK(OSTCBCur == &OSTCBTbl[Basic_Mid_PRIO]);
+	Basic_MidRuns++;
+}
+
+static void Basic_Low(void)
+{
+	BASIC_CHK(OSTCBCur == &OSTCBTbl[Basic_Low_PRIO]);
+	BASIC_CHK(BASIC_IN_SHARED_STK(Basic_SP));
+	OSTaskActivate(Basic_Mid_PRIO);         /* From a basic task: nested call      */
+	BASIC_CHK(Basic_MidRuns == 1);
+	Basic_LowRuns++;
+}
+
+int main(void)
+{
+	OSInit();
+	OSTaskCreate((void (*)(void))0, &Basic_Caller_Stk[Basic_Caller_STK_SIZE - 1], Basic_Caller_PRIO);
+	OSTaskCreateBasic(Basic_High, Basic_High_PRIO);
+	OSTaskCreateBasic(Basic_Mid,  Basic_Mid_PRIO);
+	OSTaskCreateBasic(Basic_Low,  Basic_Low_PRIO);
+	Host_IRQInit(Basic_ISR);
+	OSTCBCur = OSTCBHighRdy;                  /* OSStart(), main() is the caller     */
+	Basic_SP = &Basic_Caller_Stk[Basic_Caller_STK_SIZE / 2];
+
+	Host_IRQArm();
+	OSTaskActivate(Basic_Low_PRIO);
+
+	BASIC_CHK((Basic_LowRuns == 1) && (Basic_MidRuns == 1) && (Basic_HighRuns == 1));
+	BASIC_CHK(BASIC_IN_SHARED_STK(Basic_LowSP));
+	BASIC_CHK(BASIC_IN_SHARED_STK(Basic_HighFrame) && (Basic_HighFrame < Basic_LowSP));
+	BASIC_CHK(OSTCBCur == &OSTCBTbl[Basic_Caller_PRIO]);
+	BASIC_CHK((OSTaskBasicRunTbl == 0) && (OSTaskBasicActTbl == 0));
+	BASIC_CHK((OSRdyTbl & ((1u << Basic_High_PRIO) | (1u << Basic_Mid_PRIO) | (1u << Basic_Low_PRIO))) == 0);
+	printf("basic_test: PASSED\n");
+	return (0);
+}
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
@@ -0,0 +1,13 @@
+/**
+  ******************************************************************************
+  * @file    os_host_cfg.h
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   MinOS configuration of the basic task test, on top of minos.h.
+  ******************************************************************************
+  */
+
+#undef  OS_TASK_BASIC_EN
+#define OS_TASK_BASIC_EN                          1
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
@@ -0,0 +1,147 @@
+/**
+  ******************************************************************************
+  * @file    heap_bench.c
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   Host benchmark of OSHeapAlloc()/OSHeapFree() against the glibc
+  *          malloc()/free().
+  *
+  *          Same pseudo-random sequence as App/Task04_HeapBench.c: allocations
+  *          of 8 to 256 bytes and frees over HEAP_BENCH_SLOTS live blocks.
+  *          Each call is timed with the time stamp counter (the monotonic
+  *          clock in ns off x86), the average and worst case are printed.
+  *          Each block is filled and checked before it is freed, and
+  *          OSHeapAlloc() must return 8 bytes aligned blocks and never fail.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "minos.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define HEAP_BENCH_SLOTS        32      /* Blocks alive at the same time       */
+#define HEAP_BENCH_OPS     1000000      /* Calls measured per allocator        */
+
+typedef struct {
+	uint64_t  AllocSum;
+	uint64_t  AllocMax;
+	uint64_t  FreeSum;
+	uint64_t  FreeMax;
+	uint32_t  NAlloc;
+	uint32_t  NFree;
+	uint32_t  Failed;                     /* Allocations which returned NULL     */
+} HEAP_BENCH_DATA;
+
+/* Private variables ---------------------------------------------------------*/
+static void     *Heap_BenchPtr[HEAP_BENCH_SLOTS];
+static uint32_t  Heap_BenchSize[HEAP_BENCH_SLOTS];
+
+
+static uint64_t Heap_Now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return (__rdtsc());
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+static void Heap_BenchFree(uint32_t slot, int libc, HEAP_BENCH_DATA *pdata)
+{
+	uint8_t  *p = Heap_BenchPtr[slot];
+	uint64_t  t0, dt;
+	uint32_t  i;
+
+	for (i = 0; i < Heap_BenchSize[slot]; i++) {
+		if (p[i] != (uint8_t)slot) {
+			fprintf(stderr, "heap_bench: block of slot %u overwritten\n", slot);
+			exit(1);
+		}
+	}
+	t0 = Heap_Now();
+	if (libc) { free(p); } else { OSHeapFree(p); }
+	dt = Heap_Now() - t0;
+	Heap_BenchPtr[slot] = NULL;
+	pdata->FreeSum += dt; pdata->NFree++;
+	if (dt > pdata->FreeMax) pdata->FreeMax = dt;
+}
+
+static void Heap_BenchRun(HEAP_BENCH_DATA *pdata, int libc)
+{
+	uint32_t seed = 1;
+	uint32_t i, slot, size;
+	uint64_t t0, dt;
+
+	memset(pdata, 0, sizeof(*pdata));
+	for (i = 0; i < HEAP_BENCH_OPS; i++) {
+		seed = seed * 1664525u + 1013904223u;                 /* Same sequence for both */
+		slot = (seed >> 8) % HEAP_BENCH_SLOTS;
+		size = 8 + ((seed >> 16) & 0xF8);
+		if (Heap_BenchPtr[slot] != NULL) {
+			Heap_BenchFree(slot, libc, pdata);
+			continue;
+		}
+		t0 = Heap_Now();
+		Heap_BenchPtr[slot] = libc ? malloc(size) : OSHeapAlloc(size);
+		dt = Heap_Now() - t0;
+		pdata->AllocSum += dt; pdata->NAlloc++;
+		if (dt > pdata->AllocMax) pdata->AllocMax = dt;
+		if (Heap_BenchPtr[slot] == NULL) {
+			pdata->Failed++;
+			continue;
+		}
+		if (((uintptr_t)Heap_BenchPtr[slot] & 7u) != 0) {
+			fprintf(stderr, "heap_bench: %p not 8 bytes aligned\n", Heap_BenchPtr[slot]);
+			exit(1);
+		}
+		Heap_BenchSize[slot] = size;
+		memset(Heap_BenchPtr[slot], (uint8_t)slot, size);
+	}
+	for (slot = 0; slot < HEAP_BENCH_SLOTS; slot++) {
+		if (Heap_BenchPtr[slot] != NULL) {
+			Heap_BenchFree(slot, libc, pdata);
+		}
+	}
+}
+
+static void Heap_BenchPrint(const char *name, const HEAP_BENCH_DATA *pdata)
+{
+	printf("heap_bench: %-12s alloc avg %5llu max %7llu   free avg %5llu max %7llu   failed %u\n", name,
+	       (unsigned long long)(pdata->AllocSum / pdata->NAlloc), (unsigned long long)pdata->AllocMax,
+	       (unsigned long long)(pdata->FreeSum  / pdata->NFree),  (unsigned long long)pdata->FreeMax,
+	       pdata->Failed);
+}
+
+int main(void)
+{
+	HEAP_BENCH_DATA bench[2];
+
+	OSInit();
+	Heap_BenchRun(&bench[0], 0);
+	Heap_BenchRun(&bench[1], 1);
+
+#if defined(__x86_64__) || defined(__i386__)
+	printf("heap_bench: %u calls each, time stamp counter ticks per call\n", HEAP_BENCH_OPS);
+#else
+	printf("heap_bench: %u calls each, ns per call\n", HEAP_BENCH_OPS);
+#endif
+	Heap_BenchPrint("OSHeapAlloc", &bench[0]);
+	Heap_BenchPrint("malloc",      &bench[1]);
+	if (bench[0].Failed != 0) {
+		fprintf(stderr, "heap_bench: FAILED\n");
+		return (1);
+	}
+	return (0);
+}
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
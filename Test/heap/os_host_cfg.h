@@ -0,0 +1,17 @@
+/**
+  ******************************************************************************
+  * @file    os_host_cfg.h
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   MinOS configuration of the heap benchmark, on top of minos.h.
+  ******************************************************************************
+  */
+
+#undef  OS_SCHED_LOCK_EN
+#define OS_SCHED_LOCK_EN                          1
+#undef  OS_HEAP_EN
+#define OS_HEAP_EN                                1
+#undef  OS_HEAP_SIZE
+#define OS_HEAP_SIZE                          16384
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
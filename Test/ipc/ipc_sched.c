@@ -0,0 +1,51 @@
+/**
+  ******************************************************************************
+  * @file    ipc_sched.c
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   Task switches of the consumer process of ipc_test.c.  MinOS is
+  *          built in this file, which needs its TCBs.
+  *
+  *          The process runs one task besides the idle task, on the stack of
+  *          main().  PendSV switching the task out means it blocked: the
+  *          idle task then waits for interrupts until one readies the task.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "minos.c"
+
+/* Public variables ----------------------------------------------------------*/
+INT32U  Ipc_Waits;                      /* Times the task blocked              */
+
+
+/**
+  * @brief  		OSStart() of the consumer process, runs its single task.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Ipc_Start(void (*task)(void))
+{
+	OSTCBCur = OSTCBHighRdy;
+	__enable_irq();
+	task();
+}
+
+/**
+  * @brief  		PendSV, see host_port.c.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Host_PendSV(void)
+{
+	OS_TCB *ptcb = OSTCBCur;
+
+	OSTCBCur = OSTCBHighRdy;
+	while (OSTCBCur != ptcb) {                /* The idle task                       */
+		Ipc_Waits++;
+		Host_IRQWait();
+		OSTCBCur = OSTCBHighRdy;
+	}
+}
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
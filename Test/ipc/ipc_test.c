@@ -0,0 +1,169 @@
+/**
+  ******************************************************************************
+  * @file    ipc_test.c
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   Host test of the inter-processor channels.
+  *
+  *          Two Linux processes stand for the two processors and share an
+  *          OS_IPC_SHM ring through a MAP_SHARED mapping.  The parent sends
+  *          IPC_TEST_MSGS messages in batches of random size, pausing now and
+  *          then so that the consumer drains the ring.
+  *
+  *          The doorbell is the interrupt of the consumer process (SIGUSR1,
+  *          see host_port.c) and its ISR calls OSIPCNotify().  The consumer
+  *          is a task blocked in OSIPCPend() whenever the ring is empty: it
+  *          only runs again once the ISR has handed it a message.  Each
+  *          message must arrive once and in order, and the consumer must have
+  *          been woken by the doorbell.  The task switches are in
+  *          ipc_sched.c.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "minos.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define IPC_TEST_MSGS       200000u     /* Messages sent through the channel   */
+#define IPC_TEST_BATCH          13u     /* Largest batch per OSIPCCommit()     */
+#define IPC_TEST_PAUSE          64u     /* Batches between two pauses          */
+#define IPC_TEST_ID              1u     /* Channel number                      */
+
+#define Ipc_Consumer_PRIO        1
+#define Ipc_Consumer_STK_SIZE  256
+
+/* Public variables ----------------------------------------------------------*/
+extern INT32U       Ipc_Waits;          /* See ipc_sched.c                     */
+void                Ipc_Start(void (*task)(void));
+
+/* Private variables ---------------------------------------------------------*/
+static OS_IPC_SHM  *Ipc_Shm;
+static OS_EVENT    *Ipc_Rx;
+static int          Ipc_Peer;           /* Consumer process                    */
+static OS_STK       Ipc_Consumer_Stk[Ipc_Consumer_STK_SIZE];
+
+
+/**
+  * @brief  		Doorbell of the producer, interrupts the consumer process.
+  * @function  	Overrides the weak default of MinOS
+  * @RunPeriod 	Each OSIPCCommit()
+	*/
+void OS_IPC_Doorbell(INT8U id)
+{
+	if (id != IPC_TEST_ID) {
+		fprintf(stderr, "ipc_test: doorbell of channel %u\n", id);
+		exit(1);
+	}
+	Host_IRQRaise(Ipc_Peer);
+}
+
+/**
+  * @brief  		Doorbell ISR of the consumer processor.
+  * @function  	None
+  * @RunPeriod 	Each doorbell
+	*/
+static void Ipc_DoorbellISR(void)
+{
+	OSIntEnter();
+	OSIPCNotify(Ipc_Rx);
+	OSIntExit();
+}
+
+/**
+  * @brief  		Producer processor.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+static void Ipc_Producer(OS_EVENT *ptx)
+{
+	INT32U seq = 0;
+	INT32U batch = 0;
+	INT32U n;
+
+	srand(1);
+	while (seq < IPC_TEST_MSGS) {
+		n = 1u + (INT32U)rand() % IPC_TEST_BATCH;
+		while ((n > 0) && (seq < IPC_TEST_MSGS)) {
+			if (OSIPCWrite(ptx, (void *)(uintptr_t)(seq + 1u)) == OS_ERR_Q_FULL) {
+				OSIPCCommit(ptx);                     /* Let the consumer catch up           */
+				usleep(10);
+				continue;
+			}
+			seq++;
+			n--;
+		}
+		OSIPCCommit(ptx);
+		if ((++batch % IPC_TEST_PAUSE) == 0) {
+			usleep(100);                          /* The consumer drains and blocks      */
+		}
+	}
+}
+
+/**
+  * @brief  		Consumer task.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+static void Ipc_Consumer(void)
+{
+	INT32U seq;
+	INT8U  err;
+	void  *pmsg;
+
+	for (seq = 0; seq < IPC_TEST_MSGS; seq++) {
+		pmsg = OSIPCPend(Ipc_Rx, 0, &err);
+		if ((err != OS_ERR_NONE) || (pmsg != (void *)(uintptr_t)(seq + 1u))) {
+			fprintf(stderr, "ipc_test: got %lu (err %u), expected %lu\n",
+			        (unsigned long)(uintptr_t)pmsg, err, (unsigned long)(seq + 1u));
+			exit(1);
+		}
+	}
+	printf("ipc_test: %u messages in order, woken %u times by the doorbell\n", seq, Ipc_Waits);
+	exit(Ipc_Waits > 0 ? 0 : 1);
+}
+
+int main(void)
+{
+	OS_EVENT *ptx;
+	int       status;
+
+	Ipc_Shm = mmap(NULL, sizeof(OS_IPC_SHM), PROT_READ | PROT_WRITE,
+	               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (Ipc_Shm == MAP_FAILED) {
+		perror("ipc_test: mmap");
+		return (1);
+	}
+
+	OSInit();
+	ptx = OSIPCCreate(Ipc_Shm, IPC_TEST_ID, OS_EVENT_TYPE_IPC_TX);  /* Before the consumer */
+
+	Host_IRQInit(Ipc_DoorbellISR);            /* Masked: the consumer isn't ready    */
+	__disable_irq();
+	Ipc_Peer = fork();
+	if (Ipc_Peer < 0) {
+		perror("ipc_test: fork");
+		return (1);
+	}
+	if (Ipc_Peer == 0) {                      /* Consumer, with its own copy of MinOS */
+		Ipc_Rx = OSIPCCreate(Ipc_Shm, 0, OS_EVENT_TYPE_IPC_RX);
+		OSTaskCreate(Ipc_Consumer, &Ipc_Consumer_Stk[Ipc_Consumer_STK_SIZE - 1], Ipc_Consumer_PRIO);
+		Ipc_Start(Ipc_Consumer);
+	}
+
+	__enable_irq();
+	alarm(60);                                /* A lost doorbell hangs the consumer  */
+	Ipc_Producer(ptx);
+	if ((waitpid(Ipc_Peer, &status, 0) != Ipc_Peer) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+		fprintf(stderr, "ipc_test: FAILED\n");
+		return (1);
+	}
+	printf("ipc_test: PASSED\n");
+	return (0);
+}
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
@@ -0,0 +1,164 @@
+/**
+  ******************************************************************************
+  * @file    host_port.c
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   Host port of MinOS for the tests under Test/ (OS_HOST_SIM).
+  *
+  *          The interrupt of a process is SIGUSR1: PRIMASK blocks it, and
+  *          its handler runs the ISR given to Host_IRQInit() the way the NVIC
+  *          would, never nested.  PendSV is taken when interrupts get
+  *          unmasked outside an ISR, by calling Host_PendSV().  Each test
+  *          supplies Host_PendSV() for the tasks it runs, the default here
+  *          ignores the request.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx.h"
+#include <signal.h>
+#include <stddef.h>
+
+/* Private variables ---------------------------------------------------------*/
+static SCB_Type               Host_SCB;
+static DWT_Type               Host_DWT;
+static CoreDebug_Type         Host_CoreDebug;
+static TIM_TypeDef            Host_TIM2;
+static RCC_TypeDef            Host_RCC;
+static volatile uint32_t      Host_PRIMASK;
+static volatile sig_atomic_t  Host_InISR;       /* In the ISR or in PendSV             */
+static volatile sig_atomic_t  Host_Armed;
+static void                 (*Host_ISR)(void);
+
+/* Public variables ----------------------------------------------------------*/
+SCB_Type        *SCB       = &Host_SCB;
+DWT_Type        *DWT       = &Host_DWT;
+CoreDebug_Type  *CoreDebug = &Host_CoreDebug;
+TIM_TypeDef     *TIM2      = &Host_TIM2;
+RCC_TypeDef     *RCC       = &Host_RCC;
+uint32_t         SystemCoreClock = 168000000u;
+
+
+static void Host_Mask(int how)
+{
+	sigset_t set;
+
+	if (Host_ISR == NULL) {                   /* No interrupt, no system call        */
+		return;
+	}
+	sigemptyset(&set);
+	sigaddset(&set, SIGUSR1);
+	sigprocmask(how, &set, NULL);
+}
+
+static void Host_Handler(int sig)
+{
+	(void)sig;
+	Host_InISR++;
+	Host_ISR();
+	Host_InISR--;
+}
+
+/**
+  * @brief  		PRIMASK read.
+  * @function  	__get_PRIMASK()
+  * @RunPeriod 	None
+	*/
+uint32_t Host_GetPRIMASK(void)
+{
+	return (Host_PRIMASK);
+}
+
+/**
+  * @brief  		PRIMASK write, takes a pending PendSV when unmasked.
+  * @function  	__set_PRIMASK(), __disable_irq(), __enable_irq()
+  * @RunPeriod 	None
+	*/
+void Host_SetPRIMASK(uint32_t primask)
+{
+	if (primask != 0) {
+		Host_Mask(SIG_BLOCK);
+		Host_PRIMASK = 1u;
+		if (Host_Armed) {                       /* Taken at the next unmasking         */
+			Host_Armed = 0;
+			raise(SIGUSR1);
+		}
+		return;
+	}
+	Host_PRIMASK = 0u;
+	if (Host_InISR) {                         /* No nesting, the handler masks it    */
+		return;
+	}
+	Host_Mask(SIG_UNBLOCK);                   /* A pending interrupt is taken here   */
+	while (SCB->ICSR & SCB_ICSR_PENDSVSET_Msk) {
+		Host_Mask(SIG_BLOCK);                   /* PendSV has the lowest priority, but */
+		SCB->ICSR &= ~SCB_ICSR_PENDSVSET_Msk;   /* ... runs masked outside of WFI      */
+		Host_InISR++;
+		Host_PendSV();
+		Host_InISR--;
+		Host_Mask(SIG_UNBLOCK);
+	}
+}
+
+/**
+  * @brief  		Installs the ISR of the process.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Host_IRQInit(void (*isr)(void))
+{
+	struct sigaction sa;
+
+	Host_ISR = isr;
+	sa.sa_handler = Host_Handler;
+	sa.sa_flags   = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGUSR1, &sa, NULL);
+}
+
+/**
+  * @brief  		Interrupts the process once it next masks then unmasks
+  *           interrupts, i.e. at the end of its next critical section.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Host_IRQArm(void)
+{
+	Host_Armed = 1;
+}
+
+/**
+  * @brief  		Interrupts process 'pid'.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Host_IRQRaise(int pid)
+{
+	kill(pid, SIGUSR1);
+}
+
+/**
+  * @brief  		Waits for an interrupt (WFI), from Host_PendSV().  The
+  *           interrupt is only taken inside the wait, so a condition checked
+  *           before the call can't be missed.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void Host_IRQWait(void)
+{
+	sigset_t set;
+
+	sigemptyset(&set);
+	sigsuspend(&set);
+}
+
+/**
+  * @brief  		Default PendSV, no task switch on the host.
+  * @function  	None
+  * @RunPeriod 	None
+	*/
+void __attribute__((weak)) Host_PendSV(void)
+{
+}
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/
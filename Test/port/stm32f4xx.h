@@ -0,0 +1,81 @@
+/**
+  ******************************************************************************
+  * @file    stm32f4xx.h
+  * @author  Windy Albert
+  * @date    19-October-2026
+  * @brief   Host stand-in for the CMSIS device header, just what MinOS uses
+  *          when built with OS_HOST_SIM.  Each Linux process is one
+  *          processor:
+  *          - PRIMASK blocks SIGUSR1, the interrupt of the process (see
+  *            host_port.c), __DMB() is a full compiler and CPU barrier.
+  *          - Setting PENDSVSET in SCB->ICSR pends PendSV, which is taken
+  *            by Host_PendSV() once interrupts are unmasked outside an ISR.
+  *          - The other core peripherals are plain structures.
+  ******************************************************************************
+  */
+
+#ifndef __STM32F4XX_H
+#define __STM32F4XX_H
+
+#include <stdint.h>
+
+typedef enum { PendSV_IRQn = -2, TIM2_IRQn = 28 } IRQn_Type;
+
+typedef struct { volatile uint32_t ICSR; } SCB_Type;
+typedef struct { volatile uint32_t CTRL; volatile uint32_t CYCCNT; } DWT_Type;
+typedef struct { volatile uint32_t DEMCR; } CoreDebug_Type;
+typedef struct { volatile uint32_t CR1, DIER, SR, EGR, CCR1, CNT, PSC, ARR; } TIM_TypeDef;
+typedef struct { volatile uint32_t APB1ENR; } RCC_TypeDef;
+
+extern SCB_Type        *SCB;
+extern DWT_Type        *DWT;
+extern CoreDebug_Type  *CoreDebug;
+extern TIM_TypeDef     *TIM2;
+extern RCC_TypeDef     *RCC;
+extern uint32_t         SystemCoreClock;
+
+#define SCB_ICSR_PENDSVSET_Msk      (1u << 28)
+#define SCB_ICSR_PENDSVCLR_Msk      (1u << 27)
+#define DWT_CTRL_CYCCNTENA_Msk      (1u <<  0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1u << 24)
+#define RCC_APB1ENR_TIM2EN          (1u <<  0)
+#define TIM_CR1_CEN                 (1u <<  0)
+#define TIM_DIER_CC1IE              (1u <<  1)
+#define TIM_SR_CC1IF                (1u <<  1)
+#define TIM_EGR_UG                  (1u <<  0)
+
+uint32_t  Host_GetPRIMASK (void);
+void      Host_SetPRIMASK (uint32_t primask);
+void      Host_IRQInit    (void (*isr)(void));
+void      Host_IRQArm     (void);
+void      Host_IRQRaise   (int pid);
+void      Host_IRQWait    (void);
+void      Host_PendSV     (void);
+
+#define __get_PRIMASK()             Host_GetPRIMASK()
+#define __set_PRIMASK(v)            Host_SetPRIMASK(v)
+#define __disable_irq()             Host_SetPRIMASK(1u)
+#define __enable_irq()              Host_SetPRIMASK(0u)
+#define __DMB()                     __sync_synchronize()
+#define __CLZ(x)                    ((x) ? (uint32_t)__builtin_clz(x) : 32u)
+#define __RBIT(x)                   Host_RBIT(x)
+#define __set_PSP(x)                ((void)(x))
+#define NVIC_SetPriority(irq, p)    ((void)(irq), (void)(p))
+#define NVIC_EnableIRQ(irq)         ((void)(irq))
+#define NVIC_SetPendingIRQ(irq)     ((void)(irq))
+
+static __inline uint32_t Host_RBIT (uint32_t x)
+{
+    uint32_t r = 0;
+    int      i;
+
+    for (i = 0; i < 32; i++) {
+        r   = (r << 1) | (x & 1u);
+        x >>= 1;
+    }
+    return (r);
+}
+
+#endif
+
+/******************* (C) COPYRIGHT 2014 Windy Albert ***********END OF FILE****/